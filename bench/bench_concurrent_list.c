@@ -0,0 +1,232 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file bench_concurrent_list.c
+ * @brief Throughput of concurrent list against a mutex protected generic list
+ *
+ * Threads run a mix of lookups, inserts and removes on random keys of a
+ * shared ordered list, once on a generic list with one mutex around every
+ * operation and once on the lock-free concurrent list. Runs with 1 to 64
+ * threads.
+ *
+ * Usage: bench_concurrent_list [key range] [operations per thread] [lookup percent]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include "generic_list.h"
+#include "concurrent_list.h"
+
+#define DEFAULT_KEY_RANGE       (1024u)
+#define DEFAULT_OPERATIONS      (200000u)
+#define DEFAULT_LOOKUP_PERCENT  (80u)
+#define MAX_THREADS             (64u)
+
+typedef struct
+{
+    bool lockFree;
+    uint32_t keyRange;
+    unsigned int operations;
+    unsigned int lookupPercent;
+    generic_list_t* locked;
+    pthread_mutex_t* lock;
+    concurrent_list_t* concurrent;
+}bench_config_t;
+
+typedef struct
+{
+    const bench_config_t* config;
+    uint32_t seed;
+}bench_worker_t;
+
+static double nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint32_t nextRandom(uint32_t* seed)
+{
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
+/* Keys are stored directly in data pointers of the baseline list */
+static void noFree(void* data)
+{
+    (void)data;
+}
+
+/* First node with key not lower than given key */
+static generic_list_node_t* lowerBound(generic_list_t* list, uintptr_t key)
+{
+    generic_list_node_t* node = list->head;
+    while ( ( NULL != node ) && ( (uintptr_t)node->data < key ) )
+    {
+        node = node->next;
+    }
+    return node;
+}
+
+static void lockedOperation(const bench_config_t* config, uint32_t op, uintptr_t key)
+{
+    generic_list_node_t* node;
+    bool present;
+    pthread_mutex_lock(config->lock);
+    node = lowerBound(config->locked, key);
+    present = ( NULL != node ) && ( (uintptr_t)node->data == key );
+    /* Lookups are done by lowerBound, updates match the lock free worker */
+    if ( ( op >= config->lookupPercent ) && ( op & 1u ) && !present )
+    {
+        (void)genericList_insertBefore(config->locked, node, (void*)key);
+    }
+    else if ( ( op >= config->lookupPercent ) && !( op & 1u ) && present )
+    {
+        (void)genericList_removeElement(config->locked, node);
+    }
+    pthread_mutex_unlock(config->lock);
+}
+
+static void* worker(void* arg)
+{
+    bench_worker_t* state = (bench_worker_t*)arg;
+    const bench_config_t* config = state->config;
+    concurrent_list_handle_t* handle = NULL;
+
+    if ( config->lockFree && ( LIST_SUCCESS != concurrentList_register(config->concurrent, &handle) ) )
+    {
+        return arg;
+    }
+    for ( unsigned int i = 0; i < config->operations; i++ )
+    {
+        uint32_t r = nextRandom(&state->seed);
+        uint32_t op = r % 100u;
+        uintptr_t key = ( r >> 8 ) % config->keyRange;
+        if ( !config->lockFree )
+        {
+            lockedOperation(config, op, key);
+        }
+        else if ( op < config->lookupPercent )
+        {
+            (void)concurrentList_find(handle, key, NULL);
+        }
+        else if ( op & 1u )
+        {
+            (void)concurrentList_insert(handle, key, NULL);
+        }
+        else
+        {
+            (void)concurrentList_remove(handle, key);
+        }
+    }
+    if ( NULL != handle )
+    {
+        (void)concurrentList_unregister(handle);
+    }
+    return NULL;
+}
+
+/* Returns million operations per second */
+static double run(const bench_config_t* config, unsigned int threads)
+{
+    pthread_t ids[MAX_THREADS];
+    bench_worker_t workers[MAX_THREADS];
+    double start = nowNs();
+    double elapsed;
+
+    for ( unsigned int t = 0; t < threads; t++ )
+    {
+        workers[t].config = config;
+        workers[t].seed = 2463534242u + t;
+        if ( 0 != pthread_create(&ids[t], NULL, worker, &workers[t]) )
+        {
+            return 0.0;
+        }
+    }
+    for ( unsigned int t = 0; t < threads; t++ )
+    {
+        pthread_join(ids[t], NULL);
+    }
+    elapsed = nowNs() - start;
+    return ( (double)threads * (double)config->operations ) / ( elapsed / 1e3 );
+}
+
+int main(int argc, char** argv)
+{
+    generic_list_t locked;
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    concurrent_list_t* concurrent = (concurrent_list_t*)malloc(sizeof(concurrent_list_t));
+    bench_config_t config = { false, DEFAULT_KEY_RANGE, DEFAULT_OPERATIONS, DEFAULT_LOOKUP_PERCENT, &locked, &lock, concurrent };
+    concurrent_list_handle_t* handle;
+
+    if ( argc > 1 )
+    {
+        config.keyRange = (uint32_t)strtoul(argv[1], NULL, 10);
+    }
+    if ( argc > 2 )
+    {
+        config.operations = (unsigned int)strtoul(argv[2], NULL, 10);
+    }
+    if ( argc > 3 )
+    {
+        config.lookupPercent = (unsigned int)strtoul(argv[3], NULL, 10);
+    }
+    if ( ( NULL == concurrent ) || ( 0 == config.keyRange ) ||
+         ( LIST_SUCCESS != genericList_newList(&locked, noFree, malloc) ) ||
+         ( LIST_SUCCESS != concurrentList_newList(concurrent, free, malloc) ) ||
+         ( LIST_SUCCESS != concurrentList_register(concurrent, &handle) ) )
+    {
+        return EXIT_FAILURE;
+    }
+
+    /* Both lists start half full */
+    for ( uintptr_t key = 0; key < config.keyRange; key += 2 )
+    {
+        (void)genericList_append(&locked, (void*)key);
+        (void)concurrentList_insert(handle, key, NULL);
+    }
+    (void)concurrentList_unregister(handle);
+
+    printf("key range: %u, operations per thread: %u, lookups: %u%%\n", config.keyRange, config.operations, config.lookupPercent);
+    printf("%8s %16s %16s\n", "threads", "mutex Mops/s", "lock-free Mops/s");
+
+    for ( unsigned int threads = 1; threads <= MAX_THREADS; threads *= 2 )
+    {
+        bench_config_t lockFree = config;
+        double lockedRate;
+        double lockFreeRate;
+        lockFree.lockFree = true;
+        lockedRate = run(&config, threads);
+        lockFreeRate = run(&lockFree, threads);
+        printf("%8u %16.2f %16.2f\n", threads, lockedRate, lockFreeRate);
+    }
+    genericList_freeList(&locked);
+    concurrentList_freeList(concurrent);
+    free(concurrent);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,256 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file bench_generic_list.c
+ * @brief Micro benchmarks for generic-list
+ *
+ * Built twice by `make bench`: once in the default checked mode and once with
+ * GENERIC_LIST_UNCHECKED and GENERIC_LIST_INLINE, so both binaries can be
+ * compared side by side.
+ *
+ * Every scenario runs with nodes from malloc and from a huge page node arena.
+ *
+ * Scale mode appends, walks and frees lists of growing size up to max
+ * elements with nodes from an arena sized for the largest list, so time per
+ * element can be compared across sizes. 100M elements take 2.4 GB.
+ *
+ * Usage: bench_checked [elements] [rounds]
+ *        bench_checked scale [max elements]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "generic_list.h"
+#include "node_arena.h"
+
+#define DEFAULT_ELEMENTS    (1000000u)
+#define DEFAULT_ROUNDS      (20u)
+#define DATA_POOL_SIZE      (1024u)
+#define RANDOM_ACCESSES     (100u)
+#define SCALE_MIN_ELEMENTS  (1000000u)
+#define SCALE_MAX_ELEMENTS  (100000000u)
+
+static uint32_t dataPool[DATA_POOL_SIZE];
+
+/* Data points into the static pool, only nodes are really freed */
+static void benchFree(void* ptr)
+{
+    if ( ( (uint32_t*)ptr < dataPool ) || ( (uint32_t*)ptr >= ( dataPool + DATA_POOL_SIZE ) ) )
+    {
+        free(ptr);
+    }
+}
+
+static double nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void report(const char* name, double elapsedNs, size_t operations)
+{
+    printf("%-24s %10.2f ns/op\n", name, elapsedNs / (double)operations);
+}
+
+/* Append elements and walk the list, returns false on failure */
+static bool fillAndTraverse(generic_list_t* list, const char* label, size_t elements, unsigned int rounds)
+{
+    char name[64];
+    volatile uintptr_t sink = 0;
+    double start;
+
+    start = nowNs();
+    for ( size_t i = 0; i < elements; i++ )
+    {
+        if ( LIST_SUCCESS != genericList_append(list, &dataPool[i % DATA_POOL_SIZE]) )
+        {
+            return false;
+        }
+    }
+    snprintf(name, sizeof(name), "%s append", label);
+    report(name, nowNs() - start, elements);
+
+    /* Iterator based traversal, the loop the inline mode is meant for */
+    start = nowNs();
+    for ( unsigned int r = 0; r < rounds; r++ )
+    {
+        genericList_rewind(list);
+        while ( !genericList_isAtEnd(list) )
+        {
+            void* data;
+            genericList_getCurrentData(list, &data);
+            sink += *(uint32_t*)data;
+            genericList_next(list);
+        }
+    }
+    snprintf(name, sizeof(name), "%s iterate", label);
+    report(name, nowNs() - start, elements * rounds);
+
+    /* Positional access from the middle of the list */
+    start = nowNs();
+    for ( unsigned int i = 0; i < RANDOM_ACCESSES; i++ )
+    {
+        void* data;
+        genericList_getDataAt64(list, ( (size_t)i * 7919u ) % elements, &data);
+        sink += *(uint32_t*)data;
+    }
+    snprintf(name, sizeof(name), "%s getDataAt", label);
+    report(name, nowNs() - start, RANDOM_ACCESSES);
+
+    (void)sink;
+    return true;
+}
+
+/* Linear phases should cost the same per element at every size */
+static int scale(size_t maxElements)
+{
+    node_arena_t arena;
+    generic_list_t list;
+
+    if ( LIST_SUCCESS != nodeArena_create(&arena, maxElements * sizeof(generic_list_node_t), NULL) )
+    {
+        return EXIT_FAILURE;
+    }
+    printf("%12s %12s %12s %12s %12s\n", "elements", "append ns", "walk ns", "freeList ns", "tail at ns");
+    for ( size_t elements = SCALE_MIN_ELEMENTS; elements <= maxElements; elements *= 10 )
+    {
+        volatile uintptr_t sink = 0;
+        double append;
+        double walk;
+        double teardown;
+        double tailAt;
+        double start;
+        void* data;
+
+        if ( ( LIST_SUCCESS != genericList_newList(&list, benchFree, malloc) ) ||
+             ( LIST_SUCCESS != nodeArena_attach(&arena, &list) ) )
+        {
+            return EXIT_FAILURE;
+        }
+        start = nowNs();
+        for ( size_t i = 0; i < elements; i++ )
+        {
+            if ( LIST_SUCCESS != genericList_append(&list, &dataPool[i % DATA_POOL_SIZE]) )
+            {
+                return EXIT_FAILURE;
+            }
+        }
+        append = nowNs() - start;
+
+        start = nowNs();
+        for ( generic_list_node_t* node = list.head; NULL != node; node = node->next )
+        {
+            sink += (uintptr_t)node->data;
+        }
+        walk = nowNs() - start;
+
+        /* Positions near the tail are reached from the tail */
+        start = nowNs();
+        for ( unsigned int i = 0; i < RANDOM_ACCESSES; i++ )
+        {
+            genericList_getDataAt64(&list, elements - 1 - i, &data);
+            sink += (uintptr_t)data;
+        }
+        tailAt = nowNs() - start;
+
+        /* Walks every node, arena frees are no-ops */
+        start = nowNs();
+        genericList_freeList(&list);
+        teardown = nowNs() - start;
+        nodeArena_reset(&arena);
+
+        printf("%12zu %12.2f %12.2f %12.2f %12.2f\n", elements, append / (double)elements, walk / (double)elements,
+               teardown / (double)elements, tailAt / (double)RANDOM_ACCESSES);
+        (void)sink;
+    }
+    nodeArena_destroy(&arena);
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv)
+{
+    generic_list_t list;
+    node_arena_t arena;
+    size_t elements = DEFAULT_ELEMENTS;
+    unsigned int rounds = DEFAULT_ROUNDS;
+    double start;
+
+    for ( uint32_t i = 0; i < DATA_POOL_SIZE; i++ )
+    {
+        dataPool[i] = i;
+    }
+    if ( ( argc > 1 ) && ( 0 == strcmp(argv[1], "scale") ) )
+    {
+        return scale( ( argc > 2 ) ? strtoul(argv[2], NULL, 10) : SCALE_MAX_ELEMENTS );
+    }
+    if ( argc > 1 )
+    {
+        elements = strtoul(argv[1], NULL, 10);
+    }
+    if ( argc > 2 )
+    {
+        rounds = (unsigned int)strtoul(argv[2], NULL, 10);
+    }
+
+#if defined(GENERIC_LIST_UNCHECKED) || defined(GENERIC_LIST_INLINE)
+    printf("mode: unchecked, inline accessors\n");
+#else
+    printf("mode: checked, out-of-line accessors\n");
+#endif
+    printf("elements: %zu, traversal rounds: %u\n", elements, rounds);
+
+    /* Nodes from malloc */
+    if ( LIST_SUCCESS != genericList_newList(&list, benchFree, malloc) )
+    {
+        return EXIT_FAILURE;
+    }
+    if ( !fillAndTraverse(&list, "malloc", elements, rounds) )
+    {
+        return EXIT_FAILURE;
+    }
+    start = nowNs();
+    genericList_freeList(&list);
+    report("malloc freeList", nowNs() - start, elements);
+
+    /* Nodes from huge page arena */
+    if ( ( LIST_SUCCESS != nodeArena_create(&arena, elements * sizeof(generic_list_node_t), NULL) ) ||
+         ( LIST_SUCCESS != genericList_newList(&list, benchFree, malloc) ) ||
+         ( LIST_SUCCESS != nodeArena_attach(&arena, &list) ) )
+    {
+        return EXIT_FAILURE;
+    }
+    if ( !fillAndTraverse(&list, "arena", elements, rounds) )
+    {
+        return EXIT_FAILURE;
+    }
+    start = nowNs();
+    nodeArena_freeList(&arena, &list);
+    nodeArena_reset(&arena);
+    report("arena freeList", nowNs() - start, elements);
+    nodeArena_destroy(&arena);
+
+    return EXIT_SUCCESS;
+}
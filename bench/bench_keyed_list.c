@@ -0,0 +1,137 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file bench_keyed_list.c
+ * @brief Key search benchmark of keyed list
+ *
+ * Compares a search through genericList_next which dereferences every
+ * element data with key column scans done by every available kernel.
+ * Searched keys are absent, so every search scans the whole list.
+ *
+ * Usage: bench_keyed_list [elements] [searches]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "generic_list.h"
+#include "keyed_list.h"
+
+#define DEFAULT_ELEMENTS    (1000000u)
+#define DEFAULT_SEARCHES    (50u)
+
+static const char* kernelNames[] = { "auto", "scalar", "sse2", "avx2" };
+
+static double nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static uint64_t extractItemKey(const void* data)
+{
+    return *(const uint64_t*)data;
+}
+
+static void benchWidth(keyed_list_width_t width, size_t elements, unsigned int searches)
+{
+    keyed_list_t list;
+    volatile size_t sink = 0;
+    double start;
+
+    if ( LIST_SUCCESS != keyedList_newList(&list, width, extractItemKey, free, malloc) )
+    {
+        return;
+    }
+    for ( size_t i = 0; i < elements; i++ )
+    {
+        uint64_t* item = (uint64_t*)malloc(sizeof(uint64_t));
+        if ( NULL == item )
+        {
+            break;
+        }
+        /* Keys never exceed 32 bits so both widths hold the same values */
+        *item = ( i * 2654435761u ) & 0x7FFFFFFFu;
+        if ( LIST_SUCCESS != keyedList_append(&list, item) )
+        {
+            free(item);
+            break;
+        }
+    }
+    printf("%s keys, %zu elements\n", ( KEYED_LIST_KEY32 == width ) ? "32 bit" : "64 bit", list.list.size);
+
+    /* Pointer chasing baseline */
+    start = nowNs();
+    for ( unsigned int s = 0; s < searches; s++ )
+    {
+        uint64_t key = 0x80000000u + s;
+        genericList_rewind(&list.list);
+        while ( !genericList_isAtEnd(&list.list) )
+        {
+            void* data;
+            genericList_getCurrentData(&list.list, &data);
+            sink += ( *(uint64_t*)data == key );
+            genericList_next(&list.list);
+        }
+    }
+    printf("  %-8s %10.3f ms/search\n", "list", ( nowNs() - start ) / 1e6 / searches);
+
+    for ( keyed_list_kernel_t kernel = KEYED_LIST_KERNEL_SCALAR; kernel <= KEYED_LIST_KERNEL_AVX2; kernel++ )
+    {
+        if ( LIST_SUCCESS != keyedList_setKernel(&list, kernel) )
+        {
+            printf("  %-8s %10s\n", kernelNames[kernel], "n/a");
+            continue;
+        }
+        start = nowNs();
+        for ( unsigned int s = 0; s < searches; s++ )
+        {
+            size_t count;
+            keyedList_count(&list, 0x80000000u + s, &count);
+            sink += count;
+        }
+        printf("  %-8s %10.3f ms/search\n", kernelNames[kernel], ( nowNs() - start ) / 1e6 / searches);
+    }
+
+    keyedList_freeList(&list);
+    (void)sink;
+}
+
+int main(int argc, char** argv)
+{
+    size_t elements = DEFAULT_ELEMENTS;
+    unsigned int searches = DEFAULT_SEARCHES;
+
+    if ( argc > 1 )
+    {
+        elements = strtoul(argv[1], NULL, 10);
+    }
+    if ( argc > 2 )
+    {
+        searches = (unsigned int)strtoul(argv[2], NULL, 10);
+    }
+    benchWidth(KEYED_LIST_KEY32, elements, searches);
+    benchWidth(KEYED_LIST_KEY64, elements, searches);
+    return EXIT_SUCCESS;
+}
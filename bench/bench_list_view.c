@@ -0,0 +1,186 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file bench_list_view.c
+ * @brief Fused view pipeline against materialised intermediate lists
+ *
+ * Runs filter -> map -> skip over a list once by building a new list after
+ * every stage and once through a lazy view pipeline.
+ *
+ * Usage: bench_list_view [elements] [rounds]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "generic_list.h"
+#include "list_view.h"
+
+#define DEFAULT_ELEMENTS    (1000000u)
+#define DEFAULT_ROUNDS      (10u)
+#define DATA_POOL_SIZE      (1024u)
+
+static uint32_t dataPool[DATA_POOL_SIZE];
+
+/* Data points into the static pool, only nodes are really freed */
+static void benchFree(void* ptr)
+{
+    if ( ( (uint32_t*)ptr < dataPool ) || ( (uint32_t*)ptr >= ( dataPool + DATA_POOL_SIZE ) ) )
+    {
+        free(ptr);
+    }
+}
+
+static double nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static bool isOdd(void* ctx, const void* data)
+{
+    (void)ctx;
+    return ( 0 != ( *(const uint32_t*)data & 1u ) );
+}
+
+/* Maps to the neighbouring pool entry */
+static void* neighbour(void* ctx, void* data)
+{
+    (void)ctx;
+    return &dataPool[( *(uint32_t*)data + 1u ) % DATA_POOL_SIZE];
+}
+
+static uint64_t materialised(generic_list_t* list, size_t skip)
+{
+    generic_list_t filtered;
+    generic_list_t mapped;
+    uint64_t sum = 0;
+    size_t index = 0;
+
+    genericList_newList(&filtered, benchFree, malloc);
+    genericList_newList(&mapped, benchFree, malloc);
+    for ( generic_list_node_t* node = list->head; NULL != node; node = node->next )
+    {
+        if ( isOdd(NULL, node->data) )
+        {
+            genericList_append(&filtered, node->data);
+        }
+    }
+    for ( generic_list_node_t* node = filtered.head; NULL != node; node = node->next )
+    {
+        genericList_append(&mapped, neighbour(NULL, node->data));
+    }
+    for ( generic_list_node_t* node = mapped.head; NULL != node; node = node->next )
+    {
+        if ( index++ >= skip )
+        {
+            sum += *(uint32_t*)node->data;
+        }
+    }
+    genericList_freeList(&filtered);
+    genericList_freeList(&mapped);
+    return sum;
+}
+
+static uint64_t fused(generic_list_t* list, size_t skip)
+{
+    list_view_t source;
+    list_view_t filter;
+    list_view_t map;
+    list_view_t rest;
+    uint64_t sum = 0;
+    void* data;
+
+    listView_source(&source, list);
+    listView_filter(&filter, &source, isOdd, NULL);
+    listView_map(&map, &filter, neighbour, NULL);
+    listView_skip(&rest, &map, skip);
+    while ( LIST_SUCCESS == listView_next(&rest, &data) )
+    {
+        sum += *(uint32_t*)data;
+    }
+    return sum;
+}
+
+int main(int argc, char** argv)
+{
+    generic_list_t list;
+    size_t elements = DEFAULT_ELEMENTS;
+    unsigned int rounds = DEFAULT_ROUNDS;
+    uint64_t expected;
+    double start;
+    double materialisedNs;
+    double fusedNs;
+
+    if ( argc > 1 )
+    {
+        elements = strtoul(argv[1], NULL, 10);
+    }
+    if ( argc > 2 )
+    {
+        rounds = (unsigned int)strtoul(argv[2], NULL, 10);
+    }
+    for ( uint32_t i = 0; i < DATA_POOL_SIZE; i++ )
+    {
+        dataPool[i] = i;
+    }
+    if ( LIST_SUCCESS != genericList_newList(&list, benchFree, malloc) )
+    {
+        return EXIT_FAILURE;
+    }
+    for ( size_t i = 0; i < elements; i++ )
+    {
+        if ( LIST_SUCCESS != genericList_append(&list, &dataPool[i % DATA_POOL_SIZE]) )
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    expected = materialised(&list, elements / 4);
+    start = nowNs();
+    for ( unsigned int r = 0; r < rounds; r++ )
+    {
+        if ( materialised(&list, elements / 4) != expected )
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    materialisedNs = nowNs() - start;
+
+    start = nowNs();
+    for ( unsigned int r = 0; r < rounds; r++ )
+    {
+        if ( fused(&list, elements / 4) != expected )
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    fusedNs = nowNs() - start;
+
+    printf("elements: %zu, rounds: %u\n", elements, rounds);
+    printf("%-24s %10.2f ns/element\n", "materialised", materialisedNs / ( (double)elements * rounds ));
+    printf("%-24s %10.2f ns/element\n", "fused view", fusedNs / ( (double)elements * rounds ));
+    genericList_freeList(&list);
+    return EXIT_SUCCESS;
+}
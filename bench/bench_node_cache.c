@@ -0,0 +1,135 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file bench_node_cache.c
+ * @brief Thread scaling benchmark of node cache
+ *
+ * Every thread repeatedly builds and tears down its own list. Runs with 1 to
+ * 64 threads, once with nodes from malloc/free and once from the node cache.
+ *
+ * Usage: bench_node_cache [list length] [rounds per thread]
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include "generic_list.h"
+#include "node_cache.h"
+
+#define DEFAULT_LIST_LENGTH     (1000u)
+#define DEFAULT_ROUNDS          (200u)
+#define MAX_THREADS             (64u)
+
+typedef struct
+{
+    bool useCache;
+    size_t listLength;
+    unsigned int rounds;
+}bench_config_t;
+
+static double nowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void* worker(void* arg)
+{
+    const bench_config_t* config = (const bench_config_t*)arg;
+    generic_list_t list;
+
+    /* Data is NULL, free(NULL) is a no-op */
+    if ( LIST_SUCCESS != genericList_newList(&list, free, malloc) )
+    {
+        return arg;
+    }
+    if ( config->useCache && ( LIST_SUCCESS != nodeCache_attach(&list) ) )
+    {
+        return arg;
+    }
+    for ( unsigned int r = 0; r < config->rounds; r++ )
+    {
+        for ( size_t i = 0; i < config->listLength; i++ )
+        {
+            if ( LIST_SUCCESS != genericList_append(&list, NULL) )
+            {
+                return arg;
+            }
+        }
+        genericList_freeList(&list);
+    }
+    return NULL;
+}
+
+/* Returns million node alloc+free pairs per second */
+static double run(const bench_config_t* config, unsigned int threads)
+{
+    pthread_t ids[MAX_THREADS];
+    double start = nowNs();
+    double elapsed;
+
+    for ( unsigned int t = 0; t < threads; t++ )
+    {
+        if ( 0 != pthread_create(&ids[t], NULL, worker, (void*)config) )
+        {
+            return 0.0;
+        }
+    }
+    for ( unsigned int t = 0; t < threads; t++ )
+    {
+        pthread_join(ids[t], NULL);
+    }
+    elapsed = nowNs() - start;
+    return ( (double)threads * (double)config->rounds * (double)config->listLength ) / ( elapsed / 1e3 );
+}
+
+int main(int argc, char** argv)
+{
+    bench_config_t config = { false, DEFAULT_LIST_LENGTH, DEFAULT_ROUNDS };
+
+    if ( argc > 1 )
+    {
+        config.listLength = strtoul(argv[1], NULL, 10);
+    }
+    if ( argc > 2 )
+    {
+        config.rounds = (unsigned int)strtoul(argv[2], NULL, 10);
+    }
+    printf("list length: %zu, rounds per thread: %u\n", config.listLength, config.rounds);
+    printf("%8s %16s %16s\n", "threads", "malloc Mops/s", "cache Mops/s");
+
+    for ( unsigned int threads = 1; threads <= MAX_THREADS; threads *= 2 )
+    {
+        bench_config_t cached = config;
+        double mallocRate;
+        double cacheRate;
+        cached.useCache = true;
+        mallocRate = run(&config, threads);
+        cacheRate = run(&cached, threads);
+        printf("%8u %16.2f %16.2f\n", threads, mallocRate, cacheRate);
+    }
+    nodeCache_trim();
+    return EXIT_SUCCESS;
+}
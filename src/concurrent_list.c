@@ -0,0 +1,535 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file concurrent_list.c
+ * @brief Lock-free ordered list for concurrent insert, remove and lookup
+ *
+ * Follows Michael's list with hazard pointers. Walking threads hold hazards
+ * on the node owning the link they came through, on the current node and on
+ * its successor, and validate both links after publishing a hazard. A node
+ * is retired only by the thread whose compare-and-swap unlinked it, retired
+ * nodes are freed by a scan of all hazards once a handle has collected
+ * CONCURRENT_LIST_RETIRE_BATCH of them.
+ *
+ * Publishing a hazard needs a full fence before validation, which would be
+ * paid for every node walked. On Linux the fence is made asymmetric: walking
+ * threads only stop the compiler from reordering and the rare scan issues
+ * membarrier(), which runs a full fence on every thread of the process.
+ *
+ */
+
+#include "concurrent_list.h"
+
+#include <string.h>
+#include <pthread.h>
+
+#if defined(__linux__) && !defined(__SANITIZE_THREAD__)
+#define CONCURRENT_LIST_MEMBARRIER
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/** Removed mark in the lowest bit of next links */
+#define MARK_BIT            ((uintptr_t)1u)
+/** Hazard slot protecting node which owns prev link */
+#define HAZARD_PREV         (2u)
+
+static pthread_once_t fenceOnce = PTHREAD_ONCE_INIT;
+static bool asymmetricFence;
+
+typedef struct
+{
+    _Atomic(uintptr_t)* prev;
+    concurrent_list_node_t* curr;
+    concurrent_list_node_t* next;
+}list_position_t;
+
+static concurrent_list_node_t* ptrOf(uintptr_t link)
+{
+    return (concurrent_list_node_t*)( link & ~MARK_BIT );
+}
+
+static bool isMarked(uintptr_t link)
+{
+    return ( 0 != ( link & MARK_BIT ) );
+}
+
+static void registerFence(void)
+{
+#if defined(CONCURRENT_LIST_MEMBARRIER)
+    asymmetricFence = ( 0 == syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) );
+#endif
+}
+
+/* Orders hazard publication before validating loads, pairs with scanFence */
+static void walkFence(void)
+{
+    if ( asymmetricFence )
+    {
+        atomic_signal_fence(memory_order_seq_cst);
+    }
+    else
+    {
+        atomic_thread_fence(memory_order_seq_cst);
+    }
+}
+
+static void scanFence(void)
+{
+#if defined(CONCURRENT_LIST_MEMBARRIER)
+    if ( asymmetricFence )
+    {
+        (void)syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0);
+        return;
+    }
+#endif
+    atomic_thread_fence(memory_order_seq_cst);
+}
+
+/* Release keeps a node protected while its hazard moves between slots */
+static void protect(concurrent_list_handle_t* handle, unsigned int slot, concurrent_list_node_t* node)
+{
+    atomic_store_explicit(&handle->hazards[slot], node, memory_order_release);
+}
+
+static void destroyNode(concurrent_list_t* list, concurrent_list_node_t* node)
+{
+    list->freeFunc(node->data);
+    list->freeFunc(node);
+}
+
+static void clearHazards(concurrent_list_handle_t* handle)
+{
+    for ( unsigned int i = 0; i < CONCURRENT_LIST_HAZARDS; i++ )
+    {
+        atomic_store_explicit(&handle->hazards[i], NULL, memory_order_release);
+    }
+}
+
+static int comparePointers(const void* a, const void* b)
+{
+    uintptr_t x = *(const uintptr_t*)a;
+    uintptr_t y = *(const uintptr_t*)b;
+    return ( x > y ) - ( x < y );
+}
+
+/* Free retired nodes which are not protected by any handle */
+static void scan(concurrent_list_handle_t* handle)
+{
+    concurrent_list_t* list = handle->list;
+    uintptr_t hazards[CONCURRENT_LIST_MAX_THREADS * CONCURRENT_LIST_HAZARDS];
+    size_t count = 0;
+    concurrent_list_node_t* node = handle->retired;
+
+    /* Unlinking happened before, walkers which did not publish their hazard
+     * by now will fail validation */
+    scanFence();
+    for ( unsigned int t = 0; t < CONCURRENT_LIST_MAX_THREADS; t++ )
+    {
+        for ( unsigned int i = 0; i < CONCURRENT_LIST_HAZARDS; i++ )
+        {
+            concurrent_list_node_t* hazard = atomic_load_explicit(&list->handles[t].hazards[i], memory_order_acquire);
+            if ( NULL != hazard )
+            {
+                hazards[count++] = (uintptr_t)hazard;
+            }
+        }
+    }
+    qsort(hazards, count, sizeof(hazards[0]), comparePointers);
+
+    handle->retired = NULL;
+    handle->retiredCount = 0;
+    while ( NULL != node )
+    {
+        concurrent_list_node_t* next = node->retiredNext;
+        uintptr_t key = (uintptr_t)node;
+        if ( NULL != bsearch(&key, hazards, count, sizeof(hazards[0]), comparePointers) )
+        {
+            /* Still protected, keep for next scan */
+            node->retiredNext = handle->retired;
+            handle->retired = node;
+            handle->retiredCount++;
+        }
+        else
+        {
+            destroyNode(list, node);
+        }
+        node = next;
+    }
+}
+
+static void retire(concurrent_list_handle_t* handle, concurrent_list_node_t* node)
+{
+    node->retiredNext = handle->retired;
+    handle->retired = node;
+    handle->retiredCount++;
+    if ( handle->retiredCount >= CONCURRENT_LIST_RETIRE_BATCH )
+    {
+        scan(handle);
+    }
+}
+
+/* Protect first node of the list */
+static concurrent_list_node_t* protectFirst(concurrent_list_handle_t* handle, unsigned int slot)
+{
+    concurrent_list_t* list = handle->list;
+    for ( ;; )
+    {
+        uintptr_t link = atomic_load(&list->head);
+        protect(handle, slot, ptrOf(link));
+        walkFence();
+        if ( atomic_load(&list->head) == link )
+        {
+            return ptrOf(link);
+        }
+    }
+}
+
+/* Protect successor of curr. Returns false when curr is no longer reachable
+ * through prev or its link changed, the walk must then restart from head */
+static bool protectNext(concurrent_list_handle_t* handle, _Atomic(uintptr_t)* prev,
+                        concurrent_list_node_t* curr, unsigned int slot, uintptr_t* link)
+{
+    *link = atomic_load(&curr->next);
+    protect(handle, slot, ptrOf(*link));
+    walkFence();
+    return ( atomic_load(&curr->next) == *link ) && ( atomic_load(prev) == (uintptr_t)curr );
+}
+
+/* Unlink marked curr from prev, the winning thread retires it */
+static bool unlinkMarked(concurrent_list_handle_t* handle, _Atomic(uintptr_t)* prev,
+                         concurrent_list_node_t* curr, concurrent_list_node_t* next)
+{
+    uintptr_t expected = (uintptr_t)curr;
+    if ( !atomic_compare_exchange_strong(prev, &expected, (uintptr_t)next) )
+    {
+        return false;
+    }
+    retire(handle, curr);
+    return true;
+}
+
+/* Find first unmarked node with key not lower than given key, unlinking
+ * marked nodes on the way. On return prev, curr and next are protected */
+static bool find(concurrent_list_handle_t* handle, uint64_t key, list_position_t* pos)
+{
+    concurrent_list_t* list = handle->list;
+restart:
+    {
+        unsigned int hazardCurr = 0;
+        unsigned int hazardNext = 1;
+        _Atomic(uintptr_t)* prev = &list->head;
+        concurrent_list_node_t* curr = protectFirst(handle, hazardCurr);
+
+        while ( NULL != curr )
+        {
+            uintptr_t link;
+            concurrent_list_node_t* next;
+            unsigned int swap;
+
+            if ( !protectNext(handle, prev, curr, hazardNext, &link) )
+            {
+                goto restart;
+            }
+            next = ptrOf(link);
+            if ( !isMarked(link) )
+            {
+                if ( curr->key >= key )
+                {
+                    pos->prev = prev;
+                    pos->curr = curr;
+                    pos->next = next;
+                    return ( curr->key == key );
+                }
+                prev = &curr->next;
+                protect(handle, HAZARD_PREV, curr);
+            }
+            else if ( !unlinkMarked(handle, prev, curr, next) )
+            {
+                goto restart;
+            }
+            curr = next;
+            swap = hazardCurr;
+            hazardCurr = hazardNext;
+            hazardNext = swap;
+        }
+        pos->prev = prev;
+        pos->curr = NULL;
+        pos->next = NULL;
+        return false;
+    }
+}
+
+list_error_t concurrentList_newList(concurrent_list_t* list, freeData freeFunc, allocData allocFunc)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == freeFunc, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == allocFunc, LIST_INVALID_PARAM );
+
+    (void)pthread_once(&fenceOnce, registerFence);
+    memset(list, 0, sizeof(*list));
+    atomic_init(&list->head, (uintptr_t)0);
+    atomic_init(&list->size, 0);
+    for ( unsigned int t = 0; t < CONCURRENT_LIST_MAX_THREADS; t++ )
+    {
+        for ( unsigned int i = 0; i < CONCURRENT_LIST_HAZARDS; i++ )
+        {
+            atomic_init(&list->handles[t].hazards[i], NULL);
+        }
+        atomic_init(&list->handles[t].active, false);
+        list->handles[t].list = list;
+    }
+    list->freeFunc = freeFunc;
+    list->allocFunc = allocFunc;
+    return LIST_SUCCESS;
+}
+
+list_error_t concurrentList_register(concurrent_list_t* list, concurrent_list_handle_t** handle)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == list ) || ( NULL == handle ), LIST_INVALID_PARAM );
+
+    for ( unsigned int t = 0; t < CONCURRENT_LIST_MAX_THREADS; t++ )
+    {
+        bool expected = false;
+        /* Retired nodes left by previous owner of the slot are taken over */
+        if ( atomic_compare_exchange_strong(&list->handles[t].active, &expected, true) )
+        {
+            *handle = &list->handles[t];
+            return LIST_SUCCESS;
+        }
+    }
+    return LIST_NO_MEM;
+}
+
+list_error_t concurrentList_unregister(concurrent_list_handle_t* handle)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == handle, LIST_INVALID_PARAM );
+
+    clearHazards(handle);
+    if ( 0 != handle->retiredCount )
+    {
+        scan(handle);
+    }
+    atomic_store_explicit(&handle->active, false, memory_order_release);
+    return LIST_SUCCESS;
+}
+
+list_error_t concurrentList_insert(concurrent_list_handle_t* handle, uint64_t key, void* data)
+{
+    concurrent_list_t* list;
+    concurrent_list_node_t* node;
+    list_position_t pos;
+
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == handle, LIST_INVALID_PARAM );
+
+    list = handle->list;
+    node = (concurrent_list_node_t*)list->allocFunc(sizeof(concurrent_list_node_t));
+    if ( NULL == node )
+    {
+        return LIST_NO_MEM;
+    }
+    node->key = key;
+    node->data = data;
+    node->retiredNext = NULL;
+
+    for ( ;; )
+    {
+        uintptr_t expected;
+        if ( find(handle, key, &pos) )
+        {
+            clearHazards(handle);
+            list->freeFunc(node);
+            return LIST_EXISTS;
+        }
+        expected = (uintptr_t)pos.curr;
+        atomic_store_explicit(&node->next, expected, memory_order_relaxed);
+        /* Publishes node fields to threads which load the link */
+        if ( atomic_compare_exchange_strong(pos.prev, &expected, (uintptr_t)node) )
+        {
+            break;
+        }
+    }
+    atomic_fetch_add_explicit(&list->size, 1, memory_order_relaxed);
+    clearHazards(handle);
+    return LIST_SUCCESS;
+}
+
+list_error_t concurrentList_remove(concurrent_list_handle_t* handle, uint64_t key)
+{
+    list_position_t pos;
+
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == handle, LIST_INVALID_PARAM );
+
+    for ( ;; )
+    {
+        uintptr_t link;
+        if ( !find(handle, key, &pos) )
+        {
+            clearHazards(handle);
+            return LIST_NOT_FOUND;
+        }
+        /* Marking the link is the linearization point of removal */
+        link = (uintptr_t)pos.next;
+        if ( atomic_compare_exchange_strong(&pos.curr->next, &link, link | MARK_BIT) )
+        {
+            break;
+        }
+    }
+    if ( !unlinkMarked(handle, pos.prev, pos.curr, pos.next) )
+    {
+        /* Let find unlink it */
+        (void)find(handle, key, &pos);
+    }
+    atomic_fetch_sub_explicit(&handle->list->size, 1, memory_order_relaxed);
+    clearHazards(handle);
+    return LIST_SUCCESS;
+}
+
+list_error_t concurrentList_find(concurrent_list_handle_t* handle, uint64_t key, void** data)
+{
+    list_position_t pos;
+
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == handle, LIST_INVALID_PARAM );
+
+    if ( !find(handle, key, &pos) )
+    {
+        clearHazards(handle);
+        return LIST_NOT_FOUND;
+    }
+    /* Hazard on the node is kept until next call */
+    if ( NULL != data )
+    {
+        *data = pos.curr->data;
+    }
+    return LIST_SUCCESS;
+}
+
+list_error_t concurrentList_forEach(concurrent_list_handle_t* handle, visitData visitor, void* ctx)
+{
+    bool visited = false;
+    uint64_t lastKey = 0;
+
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == handle ) || ( NULL == visitor ), LIST_INVALID_PARAM );
+
+restart:
+    {
+        unsigned int hazardCurr = 0;
+        unsigned int hazardNext = 1;
+        _Atomic(uintptr_t)* prev = &handle->list->head;
+        concurrent_list_node_t* curr = protectFirst(handle, hazardCurr);
+
+        while ( NULL != curr )
+        {
+            uintptr_t link;
+            concurrent_list_node_t* next;
+            unsigned int swap;
+
+            if ( !protectNext(handle, prev, curr, hazardNext, &link) )
+            {
+                goto restart;
+            }
+            next = ptrOf(link);
+            if ( !isMarked(link) )
+            {
+                /* After a restart keys up to the last visited one are skipped */
+                if ( !visited || ( curr->key > lastKey ) )
+                {
+                    if ( !visitor(ctx, curr->key, curr->data) )
+                    {
+                        break;
+                    }
+                    visited = true;
+                    lastKey = curr->key;
+                }
+                prev = &curr->next;
+                protect(handle, HAZARD_PREV, curr);
+            }
+            else if ( !unlinkMarked(handle, prev, curr, next) )
+            {
+                goto restart;
+            }
+            curr = next;
+            swap = hazardCurr;
+            hazardCurr = hazardNext;
+            hazardNext = swap;
+        }
+    }
+    clearHazards(handle);
+    return LIST_SUCCESS;
+}
+
+size_t concurrentList_size(concurrent_list_t* list)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, 0 );
+    return atomic_load_explicit(&list->size, memory_order_relaxed);
+}
+
+list_error_t concurrentList_freeList(concurrent_list_t* list)
+{
+    concurrent_list_node_t* node;
+
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    for ( unsigned int t = 0; t < CONCURRENT_LIST_MAX_THREADS; t++ )
+    {
+        if ( atomic_load(&list->handles[t].active) )
+        {
+            return LIST_INVALID_PARAM;
+        }
+    }
+
+    /* Linked nodes, including marked ones nobody unlinked yet */
+    node = ptrOf(atomic_load(&list->head));
+    while ( NULL != node )
+    {
+        concurrent_list_node_t* next = ptrOf(atomic_load_explicit(&node->next, memory_order_relaxed));
+        destroyNode(list, node);
+        node = next;
+    }
+    atomic_store(&list->head, (uintptr_t)0);
+    atomic_store(&list->size, 0);
+
+    /* Nodes retired by handles */
+    for ( unsigned int t = 0; t < CONCURRENT_LIST_MAX_THREADS; t++ )
+    {
+        concurrent_list_handle_t* handle = &list->handles[t];
+        node = handle->retired;
+        while ( NULL != node )
+        {
+            concurrent_list_node_t* next = node->retiredNext;
+            destroyNode(list, node);
+            node = next;
+        }
+        handle->retired = NULL;
+        handle->retiredCount = 0;
+    }
+    return LIST_SUCCESS;
+}
@@ -0,0 +1,176 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file concurrent_list.h
+ * @brief Lock-free ordered list for concurrent insert, remove and lookup
+ *
+ * Elements are kept ordered by a 64 bit key, which gives every element a
+ * stable position independent of other threads. Insert, remove, lookup and
+ * traversal may be called from any number of threads at the same time
+ * (Harris/Michael list): removal first marks the link of the element, after
+ * which any thread may unlink it with a single compare-and-swap.
+ *
+ * Unlinked nodes are reclaimed with hazard pointers. Every thread registers
+ * a handle once and passes it to all operations, a node is freed together
+ * with its data only when no handle protects it.
+ *
+ */
+
+#ifndef SRC_TOOLS_CONCURRENT_LIST_H_
+#define SRC_TOOLS_CONCURRENT_LIST_H_
+
+#include "generic_list.h"
+
+#include <stdatomic.h>
+
+/* Structures below use C11 _Atomic members which C++ can not declare */
+#ifdef __cplusplus
+#error "concurrent_list.h is C only"
+#endif
+
+/** Maximum number of handles registered at the same time */
+#define CONCURRENT_LIST_MAX_THREADS     (64)
+/** Hazard pointers per handle */
+#define CONCURRENT_LIST_HAZARDS         (3)
+/** Retired nodes per handle which trigger a reclamation scan */
+#define CONCURRENT_LIST_RETIRE_BATCH    (2 * CONCURRENT_LIST_MAX_THREADS * CONCURRENT_LIST_HAZARDS)
+
+typedef struct concurrent_list_node_t
+{
+    uint64_t key;
+    void* data;
+    /* Next node, lowest bit marks this node as removed */
+    _Atomic(uintptr_t) next;
+    struct concurrent_list_node_t* retiredNext;
+}concurrent_list_node_t;
+
+typedef struct concurrent_list_handle_t
+{
+    _Atomic(concurrent_list_node_t*) hazards[CONCURRENT_LIST_HAZARDS];
+    _Atomic(bool) active;
+    struct concurrent_list_t* list;
+    /* Owner side state */
+    concurrent_list_node_t* retired;
+    size_t retiredCount;
+}__attribute__((aligned(64))) concurrent_list_handle_t;
+
+typedef struct concurrent_list_t
+{
+    _Atomic(uintptr_t) head;
+    _Atomic(size_t) size;
+    freeData freeFunc;
+    allocData allocFunc;
+    concurrent_list_handle_t handles[CONCURRENT_LIST_MAX_THREADS];
+}concurrent_list_t;
+
+/** Traversal visitor, returning false stops the traversal */
+typedef bool (*visitData)(void* ctx, uint64_t key, void* data);
+
+/** @brief Create new concurrent list
+ *
+ * @param[in]   list        pointer to list context structure
+ * @param[in]   freeFunc    pointer to function used to free memory @ref freeData
+ * @param[in]   allocFunc   pointer to function used to allocate memory @ref allocData
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t concurrentList_newList(concurrent_list_t* list, freeData freeFunc, allocData allocFunc);
+
+/** @brief Register calling thread with the list
+ *
+ * @param[in]    list     pointer to list context structure
+ * @param[out]   handle   set to handle used by the calling thread in all further calls
+ *
+ * @return LIST_SUCCESS on success, LIST_NO_MEM if all handles are taken. @ref list_error_t
+ */
+list_error_t concurrentList_register(concurrent_list_t* list, concurrent_list_handle_t** handle);
+
+/** @brief Release handle, nodes it retired are freed by a later scan or freeList
+ *
+ * @param[in]   handle   handle returned by @ref concurrentList_register
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t concurrentList_unregister(concurrent_list_handle_t* handle);
+
+/** @brief Insert new element at the position given by its key
+ *
+ * @param[in]   handle   handle of the calling thread
+ * @param[in]   key      element key
+ * @param[in]   data     pointer to data that will be stored in the list
+ *
+ * @return LIST_SUCCESS on success, LIST_EXISTS if key is already in the list,
+ *         data then stays with the caller. @ref list_error_t
+ */
+list_error_t concurrentList_insert(concurrent_list_handle_t* handle, uint64_t key, void* data);
+
+/** @brief Remove element with given key
+ *         NOTE: Data is freed once no thread can reach the element anymore
+ *
+ * @param[in]   handle   handle of the calling thread
+ * @param[in]   key      element key
+ *
+ * @return LIST_SUCCESS on success, LIST_NOT_FOUND if key is not in the list. @ref list_error_t
+ */
+list_error_t concurrentList_remove(concurrent_list_handle_t* handle, uint64_t key);
+
+/** @brief Find element with given key
+ *         Data stays valid until the next call made with the same handle
+ *
+ * @param[in]    handle   handle of the calling thread
+ * @param[in]    key      element key
+ * @param[out]   data     set to data of the element, may be NULL
+ *
+ * @return LIST_SUCCESS on success, LIST_NOT_FOUND if key is not in the list. @ref list_error_t
+ */
+list_error_t concurrentList_find(concurrent_list_handle_t* handle, uint64_t key, void** data);
+
+/** @brief Visit elements in key order
+ *         Elements inserted or removed during the traversal may or may not be
+ *         visited, every key is visited at most once
+ *
+ * @param[in]   handle    handle of the calling thread
+ * @param[in]   visitor   function called for each element @ref visitData
+ * @param[in]   ctx       pointer passed to visitor
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t concurrentList_forEach(concurrent_list_handle_t* handle, visitData visitor, void* ctx);
+
+/** @brief Get number of elements, exact only while no thread modifies the list
+ *
+ * @param[in]   list   pointer to list context structure
+ *
+ * @return number of elements
+ */
+size_t concurrentList_size(concurrent_list_t* list);
+
+/** @brief Free list and its elements
+ *         All handles must be unregistered
+ *
+ * @param[in]   list   pointer to list context structure
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t concurrentList_freeList(concurrent_list_t* list);
+
+#endif /* SRC_TOOLS_CONCURRENT_LIST_H_ */
@@ -31,41 +31,111 @@
  *
  */
 
+/* Always emit out-of-line hot path functions, regardless of the mode users
+ * include the header in */
+#undef GENERIC_LIST_INLINE
+#define GENERIC_LIST_DEFINE_HOT_PATHS
 #include "generic_list.h"
 
-list_error_t genericList_newList(generic_list_t* list, freeData freeFunc, allocData allocFunc)
+#if defined(GENERIC_LIST_INSTRUMENT)
+#include "list_metrics.h"
+#endif
+
+/* USDT probes generic_list:<function>_entry(list) and
+ * generic_list:<function>_return(list, err), single nops until attached.
+ * Hot path accessors have none, they are meant to be inlined into loops */
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>) && !defined(GENERIC_LIST_NO_PROBES)
+#include <sys/sdt.h>
+#define GENERIC_LIST_PROBES
+#endif
+#endif
+
+#if defined(GENERIC_LIST_PROBES)
+#define LIST_PROBE_ENTRY(name, list)        DTRACE_PROBE1(generic_list, name##_entry, list)
+#define LIST_PROBE_RETURN(name, list, err)  DTRACE_PROBE2(generic_list, name##_return, list, err)
+#else
+#define LIST_PROBE_ENTRY(name, list)        do { } while ( 0 )
+#define LIST_PROBE_RETURN(name, list, err)  do { } while ( 0 )
+#endif
+
+#if defined(GENERIC_LIST_INSTRUMENT)
+#define LIST_TIMED_ENTRY(name, list)            LIST_PROBE_ENTRY(name, list); uint64_t traceStart = listMetrics_now()
+#define LIST_TIMED_RETURN(name, list, err, op)  recordLatency(list, op, traceStart); LIST_PROBE_RETURN(name, list, err)
+#else
+#define LIST_TIMED_ENTRY(name, list)            LIST_PROBE_ENTRY(name, list)
+#define LIST_TIMED_RETURN(name, list, err, op)  LIST_PROBE_RETURN(name, list, err)
+#endif
+
+static generic_list_node_t* allocListNode(generic_list_t* list)
 {
-    /* validate params */
-    if (NULL == list)
+    if ( NULL != list->nodeAllocFunc )
     {
-        return LIST_INVALID_PARAM;
+        return (generic_list_node_t*)list->nodeAllocFunc(list->nodeAllocCtx, sizeof(generic_list_node_t));
     }
-    if (NULL == freeFunc)
+    return (generic_list_node_t*)list->allocFunc(sizeof(generic_list_node_t));
+}
+
+static void freeListNode(generic_list_t* list, generic_list_node_t* node)
+{
+    if ( NULL != list->nodeFreeFunc )
     {
-        return LIST_INVALID_PARAM;
+        list->nodeFreeFunc(list->nodeAllocCtx, node);
     }
-    if (NULL == allocFunc)
+    else
     {
-        return LIST_INVALID_PARAM;
+        list->freeFunc(node);
     }
+}
+
+/* Probes and latency recording wrap every public function, implementations
+ * call each other directly so nested work is not traced twice */
+static list_error_t appendNode(generic_list_t* list, void* data);
+static list_error_t insertBeforeNode(generic_list_t* list, generic_list_node_t* node, void* data);
+static list_error_t elementAt(generic_list_t* list, size_t index, generic_list_node_t** data);
+static list_error_t removeNode(generic_list_t* list, generic_list_node_t* node);
+
+static list_error_t initList(generic_list_t* list, freeData freeFunc, allocData allocFunc)
+{
+    /* validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == freeFunc, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == allocFunc, LIST_INVALID_PARAM );
     /* initialize list structure */
     list->size = 0;
     list->allocFunc = allocFunc;
     list->freeFunc = freeFunc;
+    list->nodeAllocFunc = NULL;
+    list->nodeFreeFunc = NULL;
+    list->nodeAllocCtx = NULL;
     list->head = NULL;
     list->tail = NULL;
     list->current = NULL;
+    list->metrics = NULL;
     return LIST_SUCCESS;
 }
 
-list_error_t genericList_append(generic_list_t* list, void* data)
+static list_error_t setNodeAllocator(generic_list_t* list, allocNode nodeAllocFunc, freeNode nodeFreeFunc, void* ctx)
 {
-    generic_list_node_t* newNode;
-    if (NULL ==list)
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( ( NULL == nodeAllocFunc ) != ( NULL == nodeFreeFunc ), LIST_INVALID_PARAM );
+    if ( NULL != list->head )
     {
+        /* Existing nodes would be freed with wrong allocator */
         return LIST_INVALID_PARAM;
     }
-    newNode = (generic_list_node_t*)list->allocFunc(sizeof(generic_list_node_t));
+    list->nodeAllocFunc = nodeAllocFunc;
+    list->nodeFreeFunc = nodeFreeFunc;
+    list->nodeAllocCtx = ctx;
+    return LIST_SUCCESS;
+}
+
+static list_error_t appendNode(generic_list_t* list, void* data)
+{
+    generic_list_node_t* newNode;
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    newNode = allocListNode(list);
     if (NULL == newNode)
     {
         return LIST_NO_MEM;
@@ -96,74 +166,72 @@ list_error_t genericList_append(generic_list_t* list, void* data)
     return LIST_SUCCESS;
 }
 
-list_error_t genericList_insert(generic_list_t* list, void* data, unsigned int index)
+static list_error_t insertAt(generic_list_t* list, void* data, size_t index)
 {
     generic_list_node_t* oldNode;
-    generic_list_node_t* newNode;
     list_error_t err;
     /* Validate params */
-    if ( NULL == list )
-    {
-        return LIST_INVALID_PARAM;
-    }
-    if ( list->size < index)
-    {
-        return LIST_INVALID_PARAM;
-    }
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( list->size < index, LIST_INVALID_PARAM );
 
     if ( list->size == index)
     {
         /* insert at end == append */
-        return genericList_append(list, data);
+        return appendNode(list, data);
     }
 
-    if ( 0 == index )
-    {
-        /* Insert as head */
-        newNode = (generic_list_node_t*)list->allocFunc(sizeof(generic_list_node_t));
-        newNode->data = data;
-        newNode->prev = NULL;
-        newNode->next = list->head;
-        list->head = newNode;
-        list->size++;
-        return LIST_SUCCESS;
-    }
-
-    /* Insert in the middle */
-    err = genericList_getElementAt(list, index, &oldNode);
+    /* Find element which will follow the new one */
+    err = elementAt(list, index, &oldNode);
     if ( LIST_SUCCESS != err )
     {
         return err;
     }
-    if ( oldNode == NULL )
+
+    return insertBeforeNode(list, oldNode, data);
+}
+
+static list_error_t insertBeforeNode(generic_list_t* list, generic_list_node_t* node, void* data)
+{
+    generic_list_node_t* newNode;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+
+    if ( NULL == node )
     {
-        return LIST_NOT_FOUND;
+        /* insert before end == append */
+        return appendNode(list, data);
     }
-    if ( NULL == oldNode->prev )
+
+    newNode = allocListNode(list);
+    if ( NULL == newNode )
     {
-        /* prev can be null only for head which would be handled before */
-        return LIST_INTERNAL_ERROR;
+        return LIST_NO_MEM;
     }
-    /* Allocate new node and change pointers */
-    newNode = (generic_list_node_t*)list->allocFunc(sizeof(generic_list_node_t));
     newNode->data = data;
-    newNode->prev = oldNode->prev;
-    newNode->next = oldNode;
-    oldNode->prev->next = newNode;
-    oldNode->prev = newNode;
+    newNode->prev = node->prev;
+    newNode->next = node;
+
+    if ( NULL != node->prev )
+    {
+        /* Not head */
+        node->prev->next = newNode;
+    }
+    else
+    {
+        /* Insert as head */
+        list->head = newNode;
+    }
+    node->prev = newNode;
     /* Update list size */
     list->size++;
 
     return LIST_SUCCESS;
 }
 
-list_error_t genericList_freeList(generic_list_t* list)
+static list_error_t freeAllNodes(generic_list_t* list)
 {
     generic_list_node_t* node;
-    if ( NULL == list )
-    {
-        return LIST_INVALID_PARAM;
-    }
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
 
     /* Get head */
     node = list->head;
@@ -176,7 +244,7 @@ list_error_t genericList_freeList(generic_list_t* list)
         /* Free data */
         list->freeFunc(node->data);
         /* Free node */
-        list->freeFunc(node);
+        freeListNode(list, node);
         /* go to next node */
         node = next;
     }
@@ -189,30 +257,31 @@ list_error_t genericList_freeList(generic_list_t* list)
     return LIST_SUCCESS;
 }
 
-list_error_t genericList_getElementAt(generic_list_t* list, unsigned int index, generic_list_node_t** data)
+static list_error_t elementAt(generic_list_t* list, size_t index, generic_list_node_t** data)
 {
     generic_list_node_t* node;
 
     /* Validate params */
-    if ( NULL == list )
-    {
-        return LIST_INVALID_PARAM;
-    }
-    if ( NULL == data )
-    {
-        return LIST_INVALID_PARAM;
-    }
-    if ( index >= list->size )
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == data, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( index >= list->size, LIST_INVALID_PARAM );
+
+    /* Go to element at index from the nearer end but watch for the end */
+    if ( index < ( list->size / 2 ) )
     {
-        return LIST_INVALID_PARAM;
+        node = list->head;
+        for ( size_t i = 0; ( ( i < index ) && ( NULL != node ) ); i++ )
+        {
+            node = node->next;
+        }
     }
-
-    /* Get head */
-    node = list->head;
-    /* Go to element at index but watch for the end*/
-    for ( unsigned int i = 0; ( ( i < index ) && ( NULL != node)); i++ )
+    else
     {
-        node = node->next;
+        node = list->tail;
+        for ( size_t i = list->size - 1; ( ( i > index ) && ( NULL != node ) ); i-- )
+        {
+            node = node->prev;
+        }
     }
     *data = node;
     /* If node is null then element has not been found */
@@ -226,21 +295,15 @@ list_error_t genericList_getElementAt(generic_list_t* list, unsigned int index,
     }
 }
 
-list_error_t genericList_getDataAt(generic_list_t* list, unsigned int index, void** data)
+static list_error_t dataAt(generic_list_t* list, size_t index, void** data)
 {
     generic_list_node_t* node;
     list_error_t err_code;
     /* Validate params */
-    if ( NULL == list )
-    {
-        return LIST_INVALID_PARAM;
-    }
-    if ( NULL == data )
-    {
-        return LIST_INVALID_PARAM;
-    }
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == data, LIST_INVALID_PARAM );
     /* Get node at index */
-    err_code = genericList_getElementAt(list, index, &node);
+    err_code = elementAt(list, index, &node);
     if ( LIST_SUCCESS != err_code )
     {
         return err_code;
@@ -252,147 +315,199 @@ list_error_t genericList_getDataAt(generic_list_t* list, unsigned int index, voi
     return LIST_SUCCESS;
 }
 
-list_error_t genericList_removeElementAt(generic_list_t* list, unsigned int index)
+static list_error_t removeAt(generic_list_t* list, size_t index)
 {
     generic_list_node_t* oldNode;
     list_error_t err;
     /* Validate params */
-    if ( NULL == list )
-    {
-        return LIST_INVALID_PARAM;
-    }
-    if ( list->size <= index)
-    {
-        return LIST_INVALID_PARAM;
-    }
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( list->size <= index, LIST_INVALID_PARAM );
 
     /* Find element to be removed */
-    err = genericList_getElementAt(list, index, &oldNode);
+    err = elementAt(list, index, &oldNode);
     if ( LIST_SUCCESS != err )
     {
         return err;
     }
-    if ( oldNode == NULL )
-    {
-        return LIST_NOT_FOUND;
-    }
 
-    if ( NULL != oldNode->prev )
+    return removeNode(list, oldNode);
+}
+
+static list_error_t removeNode(generic_list_t* list, generic_list_node_t* node)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == node, LIST_INVALID_PARAM );
+
+    if ( NULL != node->prev )
     {
         /* Not head */
-        oldNode->prev->next = oldNode->next;
+        node->prev->next = node->next;
     }
     else
     {
         /* This is head */
-        list->head = oldNode->next;
+        list->head = node->next;
     }
-    if ( NULL != oldNode->next )
+    if ( NULL != node->next )
     {
-        oldNode->next->prev = oldNode->prev;
+        node->next->prev = node->prev;
     }
     else
     {
         /* This is tail */
-        list->tail = oldNode->prev;
+        list->tail = node->prev;
+    }
+    if ( list->current == node )
+    {
+        /* Keep iteration valid */
+        list->current = node->next;
     }
     /* Free memory */
-    list->freeFunc(oldNode->data);
-    list->freeFunc(oldNode);
+    list->freeFunc(node->data);
+    freeListNode(list, node);
 
     /* Update list size */
-    list->size++;
+    list->size--;
 
     return LIST_SUCCESS;
 }
 
-list_error_t genericList_rewind(generic_list_t* list)
+#if defined(GENERIC_LIST_INSTRUMENT)
+static void recordLatency(generic_list_t* list, list_op_t op, uint64_t start)
 {
-    /* Validate params */
-    if ( NULL == list )
+    uint64_t ns = listMetrics_now() - start;
+    (void)listMetrics_record(listMetrics_global(), op, ns);
+    if ( ( NULL != list ) && ( NULL != list->metrics ) )
     {
-        return LIST_INVALID_PARAM;
+        (void)listMetrics_record(list->metrics, op, ns);
     }
-    list->current = list->head;
-    return LIST_SUCCESS;
 }
+#endif
 
+list_error_t genericList_newList(generic_list_t* list, freeData freeFunc, allocData allocFunc)
+{
+    list_error_t err;
+    LIST_PROBE_ENTRY(new_list, list);
+    err = initList(list, freeFunc, allocFunc);
+    LIST_PROBE_RETURN(new_list, list, err);
+    return err;
+}
+
+list_error_t genericList_setNodeAllocator(generic_list_t* list, allocNode nodeAllocFunc, freeNode nodeFreeFunc, void* ctx)
+{
+    list_error_t err;
+    LIST_PROBE_ENTRY(set_node_allocator, list);
+    err = setNodeAllocator(list, nodeAllocFunc, nodeFreeFunc, ctx);
+    LIST_PROBE_RETURN(set_node_allocator, list, err);
+    return err;
+}
 
-list_error_t genericList_next(generic_list_t* list)
+static list_error_t setMetrics(generic_list_t* list, struct list_metrics_t* metrics)
 {
     /* Validate params */
-    if ( NULL == list )
-    {
-        return LIST_INVALID_PARAM;
-    }
-    if ( 0 == list->size )
-    {
-        return LIST_INVALID_PARAM;
-    }
-    if ( NULL == list->current )
-    {
-        return LIST_NOT_FOUND;
-    }
-    list->current = list->current->next;
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    list->metrics = metrics;
     return LIST_SUCCESS;
 }
 
-bool genericList_isAtEnd(generic_list_t* list)
+list_error_t genericList_setMetrics(generic_list_t* list, struct list_metrics_t* metrics)
 {
-    /* Validate params */
-    if ( NULL == list )
-    {
-        return false;
-    }
-    if ( NULL == list->current )
-    {
-        return true;
-    }
-    return false;
+    list_error_t err;
+    LIST_PROBE_ENTRY(set_metrics, list);
+    err = setMetrics(list, metrics);
+    LIST_PROBE_RETURN(set_metrics, list, err);
+    return err;
 }
 
-bool genericList_isAtLastElement(generic_list_t* list)
+list_error_t genericList_append(generic_list_t* list, void* data)
 {
-    /* Validate params */
-    if ( NULL == list )
-    {
-        return false;
-    }
-    if ( NULL == list->current )
-    {
-        return false;
-    }
-    if ( NULL == list->current->next )
-    {
-        return true;
-    }
-    return false;
+    list_error_t err;
+    LIST_TIMED_ENTRY(append, list);
+    err = appendNode(list, data);
+    LIST_TIMED_RETURN(append, list, err, LIST_OP_APPEND);
+    return err;
 }
 
-list_error_t genericList_getCurrentElement(generic_list_t* list, generic_list_node_t** data)
+list_error_t genericList_insert(generic_list_t* list, void* data, unsigned int index)
 {
-    /* Validate params */
-    if ( ( NULL == list ) ||  ( NULL == data ) )
-    {
-        return LIST_INVALID_PARAM;
-    }
-    *data = list->current;
-    return LIST_SUCCESS;
+    return genericList_insert64(list, data, (size_t)index);
 }
 
-list_error_t genericList_getCurrentData(generic_list_t* list, void** data)
+list_error_t genericList_insert64(generic_list_t* list, void* data, size_t index)
 {
-    /* Validate params */
-    if ( ( NULL == list ) ||  ( NULL == data ) )
-    {
-        return LIST_INVALID_PARAM;
-    }
-    if ( NULL == list->current )
-    {
-        return LIST_NOT_FOUND;
-    }
+    list_error_t err;
+    LIST_TIMED_ENTRY(insert, list);
+    err = insertAt(list, data, index);
+    LIST_TIMED_RETURN(insert, list, err, LIST_OP_INSERT);
+    return err;
+}
 
-    *data = list->current->data;
+list_error_t genericList_insertBefore(generic_list_t* list, generic_list_node_t* node, void* data)
+{
+    list_error_t err;
+    LIST_TIMED_ENTRY(insert_before, list);
+    err = insertBeforeNode(list, node, data);
+    LIST_TIMED_RETURN(insert_before, list, err, LIST_OP_INSERT);
+    return err;
+}
 
-    return LIST_SUCCESS;
+list_error_t genericList_freeList(generic_list_t* list)
+{
+    list_error_t err;
+    LIST_TIMED_ENTRY(free_list, list);
+    err = freeAllNodes(list);
+    LIST_TIMED_RETURN(free_list, list, err, LIST_OP_FREE_LIST);
+    return err;
+}
+
+list_error_t genericList_getElementAt(generic_list_t* list, unsigned int index, generic_list_node_t** data)
+{
+    return genericList_getElementAt64(list, (size_t)index, data);
+}
+
+list_error_t genericList_getElementAt64(generic_list_t* list, size_t index, generic_list_node_t** data)
+{
+    list_error_t err;
+    LIST_TIMED_ENTRY(get_element_at, list);
+    err = elementAt(list, index, data);
+    LIST_TIMED_RETURN(get_element_at, list, err, LIST_OP_GET_ELEMENT_AT);
+    return err;
+}
+
+list_error_t genericList_getDataAt(generic_list_t* list, unsigned int index, void** data)
+{
+    return genericList_getDataAt64(list, (size_t)index, data);
+}
+
+list_error_t genericList_getDataAt64(generic_list_t* list, size_t index, void** data)
+{
+    list_error_t err;
+    LIST_TIMED_ENTRY(get_data_at, list);
+    err = dataAt(list, index, data);
+    LIST_TIMED_RETURN(get_data_at, list, err, LIST_OP_GET_ELEMENT_AT);
+    return err;
+}
+
+list_error_t genericList_removeElementAt(generic_list_t* list, unsigned int index)
+{
+    return genericList_removeElementAt64(list, (size_t)index);
+}
+
+list_error_t genericList_removeElementAt64(generic_list_t* list, size_t index)
+{
+    list_error_t err;
+    LIST_TIMED_ENTRY(remove_element_at, list);
+    err = removeAt(list, index);
+    LIST_TIMED_RETURN(remove_element_at, list, err, LIST_OP_REMOVE_ELEMENT_AT);
+    return err;
+}
+
+list_error_t genericList_removeElement(generic_list_t* list, generic_list_node_t* node)
+{
+    list_error_t err;
+    LIST_TIMED_ENTRY(remove_element, list);
+    err = removeNode(list, node);
+    LIST_TIMED_RETURN(remove_element, list, err, LIST_OP_REMOVE_ELEMENT_AT);
+    return err;
 }
@@ -40,6 +40,43 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Build configuration
+ *
+ * GENERIC_LIST_UNCHECKED - compile out parameter validation (NULL list/output
+ *                          pointers, index ranges). Passing invalid parameters
+ *                          is undefined behaviour in this mode. Checked mode
+ *                          is the default and should be kept for debug builds.
+ * GENERIC_LIST_INLINE    - define iteration functions and current element
+ *                          accessors as static inline in this header so that
+ *                          loops over the list do not pay for out-of-line calls.
+ *                          generic_list.c always provides out-of-line versions,
+ *                          so translation units may mix both modes.
+ * GENERIC_LIST_INSTRUMENT - record latency of list operations in histograms,
+ *                          see list_metrics.h. Only generic_list.c needs to be
+ *                          built with it.
+ * GENERIC_LIST_NO_PROBES - leave out USDT probes, which are otherwise built in
+ *                          whenever <sys/sdt.h> is available. Every function
+ *                          defined in generic_list.c has entry and return
+ *                          probes except the hot path accessors below, which
+ *                          run once per element and share their definition
+ *                          with the inline build.
+ */
+#if defined(GENERIC_LIST_UNCHECKED)
+#define GENERIC_LIST_VALIDATE(cond, err)    do { } while ( 0 )
+#else
+#define GENERIC_LIST_VALIDATE(cond, err)    do { if ( cond ) { return (err); } } while ( 0 )
+#endif
+
+#if defined(GENERIC_LIST_INLINE)
+#define GENERIC_LIST_HOT    static inline
+#else
+#define GENERIC_LIST_HOT
+#endif
+
 typedef enum
 {
     LIST_SUCCESS = 0,
@@ -48,11 +85,15 @@ typedef enum
     LIST_NOT_FOUND,
     LIST_EMPTY,
     LIST_NOT_IMPLEMENTED,
-    LIST_INTERNAL_ERROR
+    LIST_INTERNAL_ERROR,
+    LIST_EXISTS
 }list_error_t;
 
 typedef void (*freeData)(void*);
 typedef void* (*allocData)(size_t);
+/** Node allocator hooks, ctx is the pointer given to genericList_setNodeAllocator */
+typedef void* (*allocNode)(void* ctx, size_t size);
+typedef void (*freeNode)(void* ctx, void* node);
 
 typedef struct list_node_t
 {
@@ -61,6 +102,8 @@ typedef struct list_node_t
     struct list_node_t* prev;
 }generic_list_node_t;
 
+struct list_metrics_t;
+
 typedef struct
 {
     size_t size;
@@ -69,6 +112,11 @@ typedef struct
     generic_list_node_t* current;
     freeData freeFunc;
     allocData allocFunc;
+    freeNode nodeFreeFunc;
+    allocNode nodeAllocFunc;
+    void* nodeAllocCtx;
+    /* Per list latency histograms, used with GENERIC_LIST_INSTRUMENT */
+    struct list_metrics_t* metrics;
 }generic_list_t;
 
 /** @brief Create new generic list
@@ -81,6 +129,30 @@ typedef struct
  */
 list_error_t genericList_newList(generic_list_t* list, freeData freeFunc, allocData allocFunc);
 
+/** @brief Use separate allocator for list nodes
+ *         By default nodes are allocated with the list allocFunc and freeFunc.
+ *         Must be called while the list is empty
+ *
+ * @param[in]   list            pointer to list context structure
+ * @param[in]   nodeAllocFunc   function used to allocate nodes @ref allocNode, NULL restores default
+ * @param[in]   nodeFreeFunc    function used to free nodes @ref freeNode, NULL restores default
+ * @param[in]   ctx             context passed to both functions
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t genericList_setNodeAllocator(generic_list_t* list, allocNode nodeAllocFunc, freeNode nodeFreeFunc, void* ctx);
+
+/** @brief Record operation latencies of the list in given metrics in
+ *         addition to global ones. Has no effect unless generic_list.c is
+ *         built with GENERIC_LIST_INSTRUMENT
+ *
+ * @param[in]   list      pointer to list context structure
+ * @param[in]   metrics   metrics to record into, NULL stops per list recording
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t genericList_setMetrics(generic_list_t* list, struct list_metrics_t* metrics);
+
 /** @brief Append list with new element
  *
  * @param[in]   list   pointer to list context structure
@@ -100,6 +172,27 @@ list_error_t genericList_append(generic_list_t* list, void* data);
  */
 list_error_t genericList_insert(generic_list_t* list, void* data, unsigned int index);
 
+/** @brief insert new element into the list at given 64-bit position
+ *
+ * @param[in]   list    pointer to list context structure
+ * @param[in]   data    pointer to data that will be stored in the list
+ * @param[in]   index   index at which new element will be inserted
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t genericList_insert64(generic_list_t* list, void* data, size_t index);
+
+/** @brief insert new element into the list in front of given node
+ *
+ * @param[in]   list    pointer to list context structure
+ * @param[in]   node    node belonging to the list, new element will be placed before it.
+ *                      NULL appends at the end of the list
+ * @param[in]   data    pointer to data that will be stored in the list
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t genericList_insertBefore(generic_list_t* list, generic_list_node_t* node, void* data);
+
 /** @brief Free list and its elements
  *         NOTE: Data stored in the list will also be freed!
  *
@@ -119,6 +212,17 @@ list_error_t genericList_freeList(generic_list_t* list);
  */
 list_error_t genericList_getElementAt(generic_list_t* list, unsigned int index, generic_list_node_t** data);
 
+/** @brief Get element at 64-bit position
+ *         List is walked from the end nearer to index
+ *
+ * @param[in]    list    pointer to list context structure
+ * @param[in]    index   element index
+ * @param[out]   data    pointer to @ref generic_list_node_t pointer that will be set to element at given index
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t genericList_getElementAt64(generic_list_t* list, size_t index, generic_list_node_t** data);
+
 /** @brief Get elements data at position
  *
  * @param[in]    list    pointer to list context structure
@@ -129,6 +233,16 @@ list_error_t genericList_getElementAt(generic_list_t* list, unsigned int index,
  */
 list_error_t genericList_getDataAt(generic_list_t* list, unsigned int index, void** data);
 
+/** @brief Get elements data at 64-bit position
+ *
+ * @param[in]    list    pointer to list context structure
+ * @param[in]    index   element index
+ * @param[out]   data    pointer to a pointer which will be set to data at element at given index
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t genericList_getDataAt64(generic_list_t* list, size_t index, void** data);
+
 /** @brief remove element at given index from list
  *
  * @param[in]   list    pointer to list context structure
@@ -138,13 +252,32 @@ list_error_t genericList_getDataAt(generic_list_t* list, unsigned int index, voi
  */
 list_error_t genericList_removeElementAt(generic_list_t* list, unsigned int index);
 
+/** @brief remove element at given 64-bit index from list
+ *
+ * @param[in]   list    pointer to list context structure
+ * @param[in]   index   index at which element will be removed
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t genericList_removeElementAt64(generic_list_t* list, size_t index);
+
+/** @brief remove given node from list
+ *         NOTE: Data stored in the node will also be freed!
+ *
+ * @param[in]   list    pointer to list context structure
+ * @param[in]   node    node belonging to the list
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t genericList_removeElement(generic_list_t* list, generic_list_node_t* node);
+
 /** @brief Set currently selected element as head
  *
  * @param[in]   list   pointer to list context structure
  *
  * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
  */
-list_error_t genericList_rewind(generic_list_t* list);
+GENERIC_LIST_HOT list_error_t genericList_rewind(generic_list_t* list);
 
 /** @brief Move currently selected element pointer to next
  *
@@ -152,7 +285,7 @@ list_error_t genericList_rewind(generic_list_t* list);
  *
  * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
  */
-list_error_t genericList_next(generic_list_t* list);
+GENERIC_LIST_HOT list_error_t genericList_next(generic_list_t* list);
 
 /** @brief Check if currently selected element pointer is NULL
  *         and therefore is at the end of the list
@@ -161,7 +294,7 @@ list_error_t genericList_next(generic_list_t* list);
  *
  * @return true is list has ended
  */
-bool genericList_isAtEnd(generic_list_t* list);
+GENERIC_LIST_HOT bool genericList_isAtEnd(generic_list_t* list);
 
 /** @brief Check if currently selected element is last (next pointer is NULL)
  *
@@ -169,7 +302,7 @@ bool genericList_isAtEnd(generic_list_t* list);
  *
  * @return true if currently selected element is last
  */
-bool genericList_isAtLastElement(generic_list_t* list);
+GENERIC_LIST_HOT bool genericList_isAtLastElement(generic_list_t* list);
 
 /** @brief Get currently selected node
  *
@@ -178,7 +311,7 @@ bool genericList_isAtLastElement(generic_list_t* list);
  *
  * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
  */
-list_error_t genericList_getCurrentElement(generic_list_t* list, generic_list_node_t** data);
+GENERIC_LIST_HOT list_error_t genericList_getCurrentElement(generic_list_t* list, generic_list_node_t** data);
 
 /** @brief Get currently selected elements data
  *
@@ -187,6 +320,76 @@ list_error_t genericList_getCurrentElement(generic_list_t* list, generic_list_no
  *
  * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
  */
-list_error_t genericList_getCurrentData(generic_list_t* list, void** data);
+GENERIC_LIST_HOT list_error_t genericList_getCurrentData(generic_list_t* list, void** data);
+
+#if defined(GENERIC_LIST_INLINE) || defined(GENERIC_LIST_DEFINE_HOT_PATHS)
+/* Hot path definitions. Included inline when GENERIC_LIST_INLINE is set and
+ * emitted as regular functions by generic_list.c. They have no USDT probes
+ * and are not timed, in either mode. */
+
+GENERIC_LIST_HOT list_error_t genericList_rewind(generic_list_t* list)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    list->current = list->head;
+    return LIST_SUCCESS;
+}
+
+GENERIC_LIST_HOT list_error_t genericList_next(generic_list_t* list)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( 0 == list->size, LIST_INVALID_PARAM );
+    if ( NULL == list->current )
+    {
+        return LIST_NOT_FOUND;
+    }
+    list->current = list->current->next;
+    return LIST_SUCCESS;
+}
+
+GENERIC_LIST_HOT bool genericList_isAtEnd(generic_list_t* list)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, false );
+    return ( NULL == list->current );
+}
+
+GENERIC_LIST_HOT bool genericList_isAtLastElement(generic_list_t* list)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, false );
+    if ( NULL == list->current )
+    {
+        return false;
+    }
+    return ( NULL == list->current->next );
+}
+
+GENERIC_LIST_HOT list_error_t genericList_getCurrentElement(generic_list_t* list, generic_list_node_t** data)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == list ) || ( NULL == data ), LIST_INVALID_PARAM );
+    *data = list->current;
+    return LIST_SUCCESS;
+}
+
+GENERIC_LIST_HOT list_error_t genericList_getCurrentData(generic_list_t* list, void** data)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == list ) || ( NULL == data ), LIST_INVALID_PARAM );
+    if ( NULL == list->current )
+    {
+        return LIST_NOT_FOUND;
+    }
+    *data = list->current->data;
+    return LIST_SUCCESS;
+}
+
+#endif /* GENERIC_LIST_INLINE || GENERIC_LIST_DEFINE_HOT_PATHS */
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* SRC_TOOLS_GENERIC_LIST_H_ */
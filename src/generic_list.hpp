@@ -0,0 +1,409 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file generic_list.hpp
+ * @brief C++17 wrapper over the generic two-way list
+ *
+ * list<T> owns a generic_list_t and stores every payload in the same block as
+ * its node, so an element costs a single allocation from the list memory
+ * resource. Nodes and payloads are allocated through the node allocator
+ * hook with the std::pmr::memory_resource as its context. Iterators walk the
+ * C nodes directly, range-for loops need no calls into generic_list.c.
+ *
+ * Lists are move-only, moving transfers head and tail in O(1). Allocation
+ * failures throw std::bad_alloc, other errors reported by the C core throw
+ * generic_list::list_exception.
+ *
+ */
+
+#ifndef SRC_TOOLS_GENERIC_LIST_HPP_
+#define SRC_TOOLS_GENERIC_LIST_HPP_
+
+#include "generic_list.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <iterator>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace generic_list
+{
+
+/** @brief Error reported by the C core */
+class list_exception : public std::runtime_error
+{
+public:
+    explicit list_exception(list_error_t err)
+        : std::runtime_error("generic list error"), err_(err)
+    {
+    }
+
+    list_error_t code() const noexcept
+    {
+        return err_;
+    }
+
+private:
+    list_error_t err_;
+};
+
+namespace detail
+{
+
+inline void check(list_error_t err)
+{
+    if ( LIST_SUCCESS == err )
+    {
+        return;
+    }
+    if ( LIST_NO_MEM == err )
+    {
+        throw std::bad_alloc();
+    }
+    throw list_exception(err);
+}
+
+/* Node and payload share one block, node first so the C core sees a
+ * generic_list_node_t at the start of every allocation */
+template <typename T>
+struct node_block
+{
+    generic_list_node_t node;
+    alignas(T) unsigned char storage[sizeof(T)];
+};
+
+} /* namespace detail */
+
+template <typename T>
+class list
+{
+    using block_t = detail::node_block<T>;
+
+public:
+    using value_type = T;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = T&;
+    using const_reference = const T&;
+    using pointer = T*;
+    using const_pointer = const T*;
+
+    /** @brief Bidirectional iterator over list nodes
+     *         end() is a NULL node, decrementing it moves to the tail
+     */
+    template <bool Const>
+    class basic_iterator
+    {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using reference = std::conditional_t<Const, const T&, T&>;
+        using pointer = std::conditional_t<Const, const T*, T*>;
+
+        basic_iterator() noexcept = default;
+
+        /* iterator converts to const_iterator */
+        template <bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+        basic_iterator(const basic_iterator<OtherConst>& other) noexcept
+            : node_(other.node_), list_(other.list_)
+        {
+        }
+
+        reference operator*() const noexcept
+        {
+            return *static_cast<pointer>(node_->data);
+        }
+
+        pointer operator->() const noexcept
+        {
+            return static_cast<pointer>(node_->data);
+        }
+
+        basic_iterator& operator++() noexcept
+        {
+            node_ = node_->next;
+            return *this;
+        }
+
+        basic_iterator operator++(int) noexcept
+        {
+            basic_iterator prev = *this;
+            node_ = node_->next;
+            return prev;
+        }
+
+        basic_iterator& operator--() noexcept
+        {
+            node_ = ( nullptr == node_ ) ? list_->tail : node_->prev;
+            return *this;
+        }
+
+        basic_iterator operator--(int) noexcept
+        {
+            basic_iterator prev = *this;
+            --*this;
+            return prev;
+        }
+
+        friend bool operator==(const basic_iterator& a, const basic_iterator& b) noexcept
+        {
+            return a.node_ == b.node_;
+        }
+
+        friend bool operator!=(const basic_iterator& a, const basic_iterator& b) noexcept
+        {
+            return a.node_ != b.node_;
+        }
+
+        /** @brief Underlying C node, NULL for end() */
+        generic_list_node_t* node() const noexcept
+        {
+            return node_;
+        }
+
+    private:
+        friend class list;
+        template <bool> friend class basic_iterator;
+
+        basic_iterator(generic_list_node_t* node, const generic_list_t* owner) noexcept
+            : node_(node), list_(owner)
+        {
+        }
+
+        generic_list_node_t* node_ = nullptr;
+        const generic_list_t* list_ = nullptr;
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
+    using reverse_iterator = std::reverse_iterator<iterator>;
+    using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+    list() : list(std::pmr::get_default_resource())
+    {
+    }
+
+    /** @brief Create empty list allocating from given memory resource */
+    explicit list(std::pmr::memory_resource* resource)
+    {
+        if ( nullptr == resource )
+        {
+            throw list_exception(LIST_INVALID_PARAM);
+        }
+        /* allocFunc is never used as payloads live in node blocks, freeFunc
+         * destroys them in place */
+        detail::check(genericList_newList(&list_, &destroyPayload, &std::malloc));
+        detail::check(genericList_setNodeAllocator(&list_, &allocBlock, &freeBlock, resource));
+    }
+
+    list(const list&) = delete;
+    list& operator=(const list&) = delete;
+
+    list(list&& other) noexcept
+        : list_(other.list_)
+    {
+        other.release();
+    }
+
+    /** @brief Destroys own elements, then takes over elements and memory
+     *         resource of other
+     */
+    list& operator=(list&& other) noexcept
+    {
+        if ( this != &other )
+        {
+            clear();
+            list_ = other.list_;
+            other.release();
+        }
+        return *this;
+    }
+
+    ~list()
+    {
+        clear();
+    }
+
+    iterator begin() noexcept { return iterator(list_.head, &list_); }
+    iterator end() noexcept { return iterator(nullptr, &list_); }
+    const_iterator begin() const noexcept { return const_iterator(list_.head, &list_); }
+    const_iterator end() const noexcept { return const_iterator(nullptr, &list_); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+    reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+    reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+    const_reverse_iterator crend() const noexcept { return rend(); }
+
+    size_type size() const noexcept { return list_.size; }
+    bool empty() const noexcept { return 0 == list_.size; }
+
+    T& front() { return *static_cast<T*>(list_.head->data); }
+    const T& front() const { return *static_cast<const T*>(list_.head->data); }
+    T& back() { return *static_cast<T*>(list_.tail->data); }
+    const T& back() const { return *static_cast<const T*>(list_.tail->data); }
+
+    /** @brief Memory resource nodes and payloads are allocated from */
+    std::pmr::memory_resource* resource() const noexcept
+    {
+        return static_cast<std::pmr::memory_resource*>(list_.nodeAllocCtx);
+    }
+
+    /** @brief Underlying C list, data pointers point to T.
+     *         Elements must not be added through the C API
+     */
+    generic_list_t* c_list() noexcept { return &list_; }
+    const generic_list_t* c_list() const noexcept { return &list_; }
+
+    /** @brief Construct new element in place in front of pos */
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args)
+    {
+        generic_list_node_t* node;
+        detail::check(genericList_insertBefore(&list_, pos.node_, nullptr));
+        node = ( nullptr == pos.node_ ) ? list_.tail : pos.node_->prev;
+        try
+        {
+            node->data = ::new (static_cast<void*>(reinterpret_cast<block_t*>(node)->storage)) T(std::forward<Args>(args)...);
+        }
+        catch ( ... )
+        {
+            /* Payload was not constructed, data is still NULL */
+            genericList_removeElement(&list_, node);
+            throw;
+        }
+        return iterator(node, &list_);
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args)
+    {
+        return *emplace(cend(), std::forward<Args>(args)...);
+    }
+
+    template <typename... Args>
+    T& emplace_front(Args&&... args)
+    {
+        return *emplace(cbegin(), std::forward<Args>(args)...);
+    }
+
+    void push_back(const T& value) { emplace_back(value); }
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+    void push_front(const T& value) { emplace_front(value); }
+    void push_front(T&& value) { emplace_front(std::move(value)); }
+
+    iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+    iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+
+    /** @brief Destroy element at pos
+     *
+     * @return iterator to the element following the removed one
+     */
+    iterator erase(const_iterator pos)
+    {
+        generic_list_node_t* next = pos.node_->next;
+        detail::check(genericList_removeElement(&list_, pos.node_));
+        return iterator(next, &list_);
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        while ( first != last )
+        {
+            first = erase(first);
+        }
+        return iterator(last.node_, &list_);
+    }
+
+    void pop_front() { erase(cbegin()); }
+    void pop_back() { erase(const_iterator(list_.tail, &list_)); }
+
+    /** @brief Destroy all elements, memory resource is kept */
+    void clear() noexcept
+    {
+        if ( nullptr != list_.head )
+        {
+            genericList_freeList(&list_);
+        }
+    }
+
+    void swap(list& other) noexcept
+    {
+        std::swap(list_, other.list_);
+    }
+
+    friend void swap(list& a, list& b) noexcept
+    {
+        a.swap(b);
+    }
+
+private:
+    static void destroyPayload(void* data)
+    {
+        if ( nullptr != data )
+        {
+            static_cast<T*>(data)->~T();
+        }
+    }
+
+    /* Node allocator hooks, node size requested by the core is ignored as
+     * every node carries its payload */
+    static void* allocBlock(void* ctx, std::size_t)
+    {
+        try
+        {
+            return static_cast<std::pmr::memory_resource*>(ctx)->allocate(sizeof(block_t), alignof(block_t));
+        }
+        catch ( ... )
+        {
+            /* Do not unwind through C frames, the core reports LIST_NO_MEM */
+            return nullptr;
+        }
+    }
+
+    static void freeBlock(void* ctx, void* node)
+    {
+        static_cast<std::pmr::memory_resource*>(ctx)->deallocate(node, sizeof(block_t), alignof(block_t));
+    }
+
+    /* Leave moved-from list empty but usable with the same resource */
+    void release() noexcept
+    {
+        list_.size = 0;
+        list_.head = nullptr;
+        list_.tail = nullptr;
+        list_.current = nullptr;
+    }
+
+    generic_list_t list_;
+};
+
+} /* namespace generic_list */
+
+#endif /* SRC_TOOLS_GENERIC_LIST_HPP_ */
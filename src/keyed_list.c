@@ -0,0 +1,453 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file keyed_list.c
+ * @brief Generic list with contiguous key column for fast searching
+ *
+ * Blocks are installed as the node allocator of the underlying generic list.
+ * Allocation takes a free slot from a block with free slots and stores the
+ * key prepared by keyedList_append/insert, freeing a node clears its slot.
+ *
+ * Search kernels compare whole key array of a block and return a bit mask
+ * of matching slots, masked afterwards with slot occupancy. SSE2 is part of
+ * x86-64 baseline, AVX2 is compiled with target attribute and chosen at run
+ * time, other architectures use the scalar kernel.
+ *
+ */
+
+#include "keyed_list.h"
+
+#if defined(__x86_64__) && ( defined(__GNUC__) || defined(__clang__) )
+#define KEYED_LIST_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+#define ALL_SLOTS_OCCUPIED  (UINT64_MAX)
+
+static uint64_t matchScalar32(const void* keys, uint64_t key)
+{
+    const uint32_t* k = (const uint32_t*)keys;
+    uint64_t mask = 0;
+    for ( unsigned int i = 0; i < KEYED_LIST_BLOCK_SIZE; i++ )
+    {
+        mask |= (uint64_t)( k[i] == (uint32_t)key ) << i;
+    }
+    return mask;
+}
+
+static uint64_t matchScalar64(const void* keys, uint64_t key)
+{
+    const uint64_t* k = (const uint64_t*)keys;
+    uint64_t mask = 0;
+    for ( unsigned int i = 0; i < KEYED_LIST_BLOCK_SIZE; i++ )
+    {
+        mask |= (uint64_t)( k[i] == key ) << i;
+    }
+    return mask;
+}
+
+#if defined(KEYED_LIST_X86_KERNELS)
+static uint64_t matchSse2_32(const void* keys, uint64_t key)
+{
+    const __m128i* k = (const __m128i*)keys;
+    const __m128i needle = _mm_set1_epi32((int)(uint32_t)key);
+    uint64_t mask = 0;
+    for ( unsigned int i = 0; i < KEYED_LIST_BLOCK_SIZE / 4; i++ )
+    {
+        __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128(&k[i]), needle);
+        mask |= (uint64_t)_mm_movemask_ps(_mm_castsi128_ps(eq)) << ( i * 4 );
+    }
+    return mask;
+}
+
+/* No 64 bit compare in SSE2, lane matches when both its 32 bit halves match */
+static inline unsigned int matchSse2Pair(const __m128i* k, __m128i needle)
+{
+    __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128(k), needle);
+    eq = _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (unsigned int)_mm_movemask_pd(_mm_castsi128_pd(eq));
+}
+
+static uint64_t matchSse2_64(const void* keys, uint64_t key)
+{
+    const __m128i* k = (const __m128i*)keys;
+    const __m128i needle = _mm_set1_epi64x((long long)key);
+    uint64_t mask = 0;
+    for ( unsigned int i = 0; i < KEYED_LIST_BLOCK_SIZE / 2; i += 4 )
+    {
+        unsigned int bits = matchSse2Pair(&k[i], needle) |
+                            ( matchSse2Pair(&k[i + 1], needle) << 2 ) |
+                            ( matchSse2Pair(&k[i + 2], needle) << 4 ) |
+                            ( matchSse2Pair(&k[i + 3], needle) << 6 );
+        mask |= (uint64_t)bits << ( i * 2 );
+    }
+    return mask;
+}
+
+__attribute__((target("avx2")))
+static uint64_t matchAvx2_32(const void* keys, uint64_t key)
+{
+    const __m256i* k = (const __m256i*)keys;
+    const __m256i needle = _mm256_set1_epi32((int)(uint32_t)key);
+    uint64_t mask = 0;
+    for ( unsigned int i = 0; i < KEYED_LIST_BLOCK_SIZE / 8; i++ )
+    {
+        __m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256(&k[i]), needle);
+        mask |= (uint64_t)(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(eq)) << ( i * 8 );
+    }
+    return mask;
+}
+
+__attribute__((target("avx2")))
+static uint64_t matchAvx2_64(const void* keys, uint64_t key)
+{
+    const __m256i* k = (const __m256i*)keys;
+    const __m256i needle = _mm256_set1_epi64x((long long)key);
+    uint64_t mask = 0;
+    for ( unsigned int i = 0; i < KEYED_LIST_BLOCK_SIZE / 4; i++ )
+    {
+        __m256i eq = _mm256_cmpeq_epi64(_mm256_loadu_si256(&k[i]), needle);
+        mask |= (uint64_t)(uint32_t)_mm256_movemask_pd(_mm256_castsi256_pd(eq)) << ( i * 4 );
+    }
+    return mask;
+}
+#endif /* KEYED_LIST_X86_KERNELS */
+
+/* Node allocator hook, takes slot from a block with free slots */
+static void* allocSlot(void* ctx, size_t size)
+{
+    keyed_list_t* list = (keyed_list_t*)ctx;
+    keyed_list_block_t* block = list->partialBlocks;
+    unsigned int slot;
+
+    /* Only keyedList_append/insert may add elements */
+    if ( ( size > sizeof(generic_list_node_t) ) || !list->keyPending )
+    {
+        return NULL;
+    }
+    if ( NULL == block )
+    {
+        block = (keyed_list_block_t*)list->list.allocFunc(sizeof(keyed_list_block_t));
+        if ( NULL == block )
+        {
+            return NULL;
+        }
+        /* Free slots are masked out by occupancy, keys are only cleared to not scan garbage */
+        for ( unsigned int i = 0; i < KEYED_LIST_BLOCK_SIZE; i++ )
+        {
+            block->keys.k64[i] = 0;
+            block->slots[i].block = block;
+        }
+        block->occupied = 0;
+        /* Keep blocks in allocation order */
+        block->next = NULL;
+        if ( NULL == list->lastBlock )
+        {
+            list->blocks = block;
+        }
+        else
+        {
+            list->lastBlock->next = block;
+        }
+        list->lastBlock = block;
+        block->nextPartial = NULL;
+        block->partial = true;
+        list->partialBlocks = block;
+    }
+
+    slot = (unsigned int)__builtin_ctzll(~block->occupied);
+    block->occupied |= (uint64_t)1 << slot;
+    if ( KEYED_LIST_KEY32 == list->width )
+    {
+        block->keys.k32[slot] = (uint32_t)list->pendingKey;
+    }
+    else
+    {
+        block->keys.k64[slot] = list->pendingKey;
+    }
+    list->keyPending = false;
+    if ( ALL_SLOTS_OCCUPIED == block->occupied )
+    {
+        /* Block is full */
+        list->partialBlocks = block->nextPartial;
+        block->partial = false;
+    }
+    return &block->slots[slot].node;
+}
+
+/* Node free hook, releases slot */
+static void freeSlot(void* ctx, void* node)
+{
+    keyed_list_t* list = (keyed_list_t*)ctx;
+    keyed_list_slot_t* slot = (keyed_list_slot_t*)node;
+    keyed_list_block_t* block = slot->block;
+
+    block->occupied &= ~( (uint64_t)1 << ( slot - block->slots ) );
+    /* Freed slot will be reused ahead of newer ones */
+    list->slotOrder = false;
+    if ( !block->partial )
+    {
+        block->nextPartial = list->partialBlocks;
+        list->partialBlocks = block;
+        block->partial = true;
+    }
+}
+
+list_error_t keyedList_newList(keyed_list_t* list, keyed_list_width_t width, extractKey extractFunc, freeData freeFunc, allocData allocFunc)
+{
+    list_error_t err;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == extractFunc, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( ( KEYED_LIST_KEY32 != width ) && ( KEYED_LIST_KEY64 != width ), LIST_INVALID_PARAM );
+
+    err = genericList_newList(&list->list, freeFunc, allocFunc);
+    if ( LIST_SUCCESS != err )
+    {
+        return err;
+    }
+    list->extractFunc = extractFunc;
+    list->width = width;
+    list->blocks = NULL;
+    list->lastBlock = NULL;
+    list->partialBlocks = NULL;
+    list->pendingKey = 0;
+    list->keyPending = false;
+    list->slotOrder = true;
+    err = genericList_setNodeAllocator(&list->list, allocSlot, freeSlot, list);
+    if ( LIST_SUCCESS != err )
+    {
+        return err;
+    }
+    return keyedList_setKernel(list, KEYED_LIST_KERNEL_AUTO);
+}
+
+list_error_t keyedList_setKernel(keyed_list_t* list, keyed_list_kernel_t kernel)
+{
+    bool wide;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+
+    wide = ( KEYED_LIST_KEY64 == list->width );
+#if defined(KEYED_LIST_X86_KERNELS)
+    if ( KEYED_LIST_KERNEL_AUTO == kernel )
+    {
+        kernel = __builtin_cpu_supports("avx2") ? KEYED_LIST_KERNEL_AVX2 : KEYED_LIST_KERNEL_SSE2;
+    }
+    switch ( kernel )
+    {
+        case KEYED_LIST_KERNEL_SCALAR:
+            list->matchFunc = wide ? matchScalar64 : matchScalar32;
+            return LIST_SUCCESS;
+        case KEYED_LIST_KERNEL_SSE2:
+            list->matchFunc = wide ? matchSse2_64 : matchSse2_32;
+            return LIST_SUCCESS;
+        case KEYED_LIST_KERNEL_AVX2:
+            if ( !__builtin_cpu_supports("avx2") )
+            {
+                return LIST_NOT_IMPLEMENTED;
+            }
+            list->matchFunc = wide ? matchAvx2_64 : matchAvx2_32;
+            return LIST_SUCCESS;
+        default:
+            return LIST_INVALID_PARAM;
+    }
+#else
+    if ( ( KEYED_LIST_KERNEL_AUTO == kernel ) || ( KEYED_LIST_KERNEL_SCALAR == kernel ) )
+    {
+        list->matchFunc = wide ? matchScalar64 : matchScalar32;
+        return LIST_SUCCESS;
+    }
+    return LIST_NOT_IMPLEMENTED;
+#endif
+}
+
+list_error_t keyedList_append(keyed_list_t* list, void* data)
+{
+    list_error_t err;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+
+    /* Picked up by slot allocator */
+    list->pendingKey = list->extractFunc(data);
+    list->keyPending = true;
+    err = genericList_append(&list->list, data);
+    list->keyPending = false;
+    return err;
+}
+
+list_error_t keyedList_insert(keyed_list_t* list, void* data, size_t index)
+{
+    list_error_t err;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+
+    /* Picked up by slot allocator */
+    list->pendingKey = list->extractFunc(data);
+    list->keyPending = true;
+    err = genericList_insert64(&list->list, data, index);
+    list->keyPending = false;
+    if ( ( LIST_SUCCESS == err ) && ( index + 1 < list->list.size ) )
+    {
+        /* Slot of element inserted in the middle may be newer than ones behind it */
+        list->slotOrder = false;
+    }
+    return err;
+}
+
+/* Check key stored in the slot of a list node */
+static bool slotHasKey(const keyed_list_t* list, generic_list_node_t* node, uint64_t key)
+{
+    keyed_list_slot_t* slot = (keyed_list_slot_t*)node;
+    size_t index = (size_t)( slot - slot->block->slots );
+
+    if ( KEYED_LIST_KEY32 == list->width )
+    {
+        return ( slot->block->keys.k32[index] == (uint32_t)key );
+    }
+    return ( slot->block->keys.k64[index] == key );
+}
+
+list_error_t keyedList_find(keyed_list_t* list, uint64_t key, generic_list_node_t** node)
+{
+    generic_list_node_t* match = NULL;
+    size_t count = 0;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == list ) || ( NULL == node ), LIST_INVALID_PARAM );
+
+    for ( keyed_list_block_t* block = list->blocks; NULL != block; block = block->next )
+    {
+        uint64_t mask = list->matchFunc(&block->keys, key) & block->occupied;
+        if ( 0 != mask )
+        {
+            if ( NULL == match )
+            {
+                match = &block->slots[__builtin_ctzll(mask)].node;
+                if ( list->slotOrder )
+                {
+                    break;
+                }
+            }
+            count += (size_t)__builtin_popcountll(mask);
+        }
+    }
+    if ( count > 1 )
+    {
+        /* Slot order is not list order anymore, first match is the first one in the list */
+        match = list->list.head;
+        while ( !slotHasKey(list, match, key) )
+        {
+            match = match->next;
+        }
+    }
+    *node = match;
+    return ( NULL == match ) ? LIST_NOT_FOUND : LIST_SUCCESS;
+}
+
+list_error_t keyedList_count(keyed_list_t* list, uint64_t key, size_t* count)
+{
+    size_t total = 0;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == list ) || ( NULL == count ), LIST_INVALID_PARAM );
+
+    for ( keyed_list_block_t* block = list->blocks; NULL != block; block = block->next )
+    {
+        total += (size_t)__builtin_popcountll(list->matchFunc(&block->keys, key) & block->occupied);
+    }
+    *count = total;
+    return LIST_SUCCESS;
+}
+
+list_error_t keyedList_findAll(keyed_list_t* list, uint64_t key, generic_list_node_t** nodes, size_t capacity, size_t* found)
+{
+    size_t written = 0;
+    size_t count;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == list ) || ( NULL == found ), LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( ( NULL == nodes ) && ( 0 != capacity ), LIST_INVALID_PARAM );
+
+    if ( !list->slotOrder )
+    {
+        (void)keyedList_count(list, key, &count);
+        if ( count > 1 )
+        {
+            /* Collect in list order, walk stops at the last match */
+            for ( generic_list_node_t* node = list->list.head; written < count; node = node->next )
+            {
+                if ( slotHasKey(list, node, key) )
+                {
+                    if ( written == capacity )
+                    {
+                        *found = written;
+                        return LIST_NO_MEM;
+                    }
+                    nodes[written++] = node;
+                }
+            }
+            *found = written;
+            return LIST_SUCCESS;
+        }
+    }
+    for ( keyed_list_block_t* block = list->blocks; NULL != block; block = block->next )
+    {
+        uint64_t mask = list->matchFunc(&block->keys, key) & block->occupied;
+        while ( 0 != mask )
+        {
+            if ( written == capacity )
+            {
+                *found = written;
+                return LIST_NO_MEM;
+            }
+            nodes[written++] = &block->slots[__builtin_ctzll(mask)].node;
+            /* Clear lowest set bit */
+            mask &= mask - 1;
+        }
+    }
+    *found = written;
+    return LIST_SUCCESS;
+}
+
+list_error_t keyedList_freeList(keyed_list_t* list)
+{
+    keyed_list_block_t* block;
+    list_error_t err;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+
+    err = genericList_freeList(&list->list);
+    if ( LIST_SUCCESS != err )
+    {
+        return err;
+    }
+    block = list->blocks;
+    while ( NULL != block )
+    {
+        keyed_list_block_t* next = block->next;
+        list->list.freeFunc(block);
+        block = next;
+    }
+    list->blocks = NULL;
+    list->lastBlock = NULL;
+    list->partialBlocks = NULL;
+    list->slotOrder = true;
+    return LIST_SUCCESS;
+}
@@ -0,0 +1,204 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file keyed_list.h
+ * @brief Generic list with contiguous key column for fast searching
+ *
+ * Every element gets a 32 or 64 bit key extracted once, when it is added to
+ * the list. Nodes live in blocks of KEYED_LIST_BLOCK_SIZE slots which also
+ * hold keys of their nodes next to each other, so searching by key scans a
+ * dense array with SIMD compares instead of chasing node and data pointers.
+ *
+ * Underlying list can be iterated and elements removed with the regular
+ * genericList_* functions, elements must only be added with keyedList_*
+ * functions, other inserts fail with LIST_NO_MEM as no slot is handed out
+ * without a key.
+ *
+ * Search results come in list order. Blocks are kept in allocation order, so
+ * while elements are only appended slot order is list order and the key
+ * column alone answers every search. Once an element is removed or inserted
+ * in the middle, a key matching more than one element is ordered by walking
+ * the list up to its last match, unique keys are still found by the column.
+ *
+ */
+
+#ifndef SRC_TOOLS_KEYED_LIST_H_
+#define SRC_TOOLS_KEYED_LIST_H_
+
+#include "generic_list.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Number of node slots per block */
+#define KEYED_LIST_BLOCK_SIZE   (64)
+
+typedef enum
+{
+    KEYED_LIST_KEY32 = 0,
+    KEYED_LIST_KEY64
+}keyed_list_width_t;
+
+typedef enum
+{
+    KEYED_LIST_KERNEL_AUTO = 0,
+    KEYED_LIST_KERNEL_SCALAR,
+    KEYED_LIST_KERNEL_SSE2,
+    KEYED_LIST_KERNEL_AVX2
+}keyed_list_kernel_t;
+
+/** Extract key from element data, 32 bit lists use the lower half */
+typedef uint64_t (*extractKey)(const void*);
+
+/** Returns bit mask of block slots whose key equals searched one */
+typedef uint64_t (*matchKeys)(const void* keys, uint64_t key);
+
+struct keyed_list_block_t;
+
+typedef struct
+{
+    generic_list_node_t node;
+    struct keyed_list_block_t* block;
+}keyed_list_slot_t;
+
+typedef struct keyed_list_block_t
+{
+    union
+    {
+        uint32_t k32[KEYED_LIST_BLOCK_SIZE];
+        uint64_t k64[KEYED_LIST_BLOCK_SIZE];
+    }keys;
+    uint64_t occupied;
+    struct keyed_list_block_t* next;
+    struct keyed_list_block_t* nextPartial;
+    bool partial;
+    keyed_list_slot_t slots[KEYED_LIST_BLOCK_SIZE];
+}keyed_list_block_t;
+
+typedef struct
+{
+    generic_list_t list;
+    extractKey extractFunc;
+    matchKeys matchFunc;
+    keyed_list_width_t width;
+    keyed_list_block_t* blocks;
+    keyed_list_block_t* lastBlock;
+    keyed_list_block_t* partialBlocks;
+    uint64_t pendingKey;
+    /* Key for the next slot was set by keyedList_append/insert */
+    bool keyPending;
+    /* Slot allocation order still matches list order */
+    bool slotOrder;
+}keyed_list_t;
+
+/** @brief Create new keyed list
+ *
+ * @param[in]   list          pointer to keyed list context structure
+ * @param[in]   width         key width @ref keyed_list_width_t
+ * @param[in]   extractFunc   function extracting key from element data @ref extractKey
+ * @param[in]   freeFunc      pointer to function used to free memory @ref freeData
+ * @param[in]   allocFunc     pointer to function used to allocate memory @ref allocData
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t keyedList_newList(keyed_list_t* list, keyed_list_width_t width, extractKey extractFunc, freeData freeFunc, allocData allocFunc);
+
+/** @brief Select search kernel, by default the best one supported by CPU is used
+ *
+ * @param[in]   list     pointer to keyed list context structure
+ * @param[in]   kernel   kernel to use @ref keyed_list_kernel_t
+ *
+ * @return LIST_SUCCESS on success, LIST_NOT_IMPLEMENTED if kernel is not supported
+ *         on this CPU, error code otherwise. @ref list_error_t
+ */
+list_error_t keyedList_setKernel(keyed_list_t* list, keyed_list_kernel_t kernel);
+
+/** @brief Append list with new element
+ *
+ * @param[in]   list   pointer to keyed list context structure
+ * @param[in]   data   pointer to data that will be stored in the list
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t keyedList_append(keyed_list_t* list, void* data);
+
+/** @brief insert new element into the list at given position
+ *
+ * @param[in]   list    pointer to keyed list context structure
+ * @param[in]   data    pointer to data that will be stored in the list
+ * @param[in]   index   index at which new element will be inserted
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t keyedList_insert(keyed_list_t* list, void* data, size_t index);
+
+/** @brief Find element with given key
+ *
+ * @param[in]    list   pointer to keyed list context structure
+ * @param[in]    key    searched key
+ * @param[out]   node   set to first matching node in list order, NULL if there is none
+ *
+ * @return LIST_SUCCESS on success, LIST_NOT_FOUND if no element matches,
+ *         error code otherwise. @ref list_error_t
+ */
+list_error_t keyedList_find(keyed_list_t* list, uint64_t key, generic_list_node_t** node);
+
+/** @brief Count elements with given key
+ *
+ * @param[in]    list    pointer to keyed list context structure
+ * @param[in]    key     searched key
+ * @param[out]   count   set to number of matching elements
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t keyedList_count(keyed_list_t* list, uint64_t key, size_t* count);
+
+/** @brief Find all elements with given key
+ *
+ * @param[in]    list       pointer to keyed list context structure
+ * @param[in]    key        searched key
+ * @param[out]   nodes      array which will be filled with matching nodes in list order
+ * @param[in]    capacity   size of nodes array
+ * @param[out]   found      set to number of nodes written
+ *
+ * @return LIST_SUCCESS on success, LIST_NO_MEM if there were more matches than capacity,
+ *         error code otherwise. @ref list_error_t
+ */
+list_error_t keyedList_findAll(keyed_list_t* list, uint64_t key, generic_list_node_t** nodes, size_t capacity, size_t* found);
+
+/** @brief Free list, its key blocks and its elements
+ *         NOTE: Data stored in the list will also be freed!
+ *
+ * @param[in]   list   pointer to keyed list context structure
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t keyedList_freeList(keyed_list_t* list);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_TOOLS_KEYED_LIST_H_ */
@@ -0,0 +1,304 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file list_metrics.c
+ * @brief Latency histograms of generic list operations
+ *
+ */
+
+#include "list_metrics.h"
+
+#include <inttypes.h>
+#include <stdatomic.h>
+#include <time.h>
+
+/** Sub-buckets per power of two */
+#define LIST_METRICS_SUB_BUCKETS    (8)
+/** Buckets covering the whole uint64_t nanosecond range */
+#define LIST_METRICS_BUCKETS        ((64 - 2) * LIST_METRICS_SUB_BUCKETS)
+/** Percentiles written by export */
+#define EXPORT_PERCENTILES          (4u)
+
+typedef struct
+{
+    _Atomic(uint64_t) buckets[LIST_METRICS_BUCKETS];
+    _Atomic(uint64_t) count;
+    _Atomic(uint64_t) sumNs;
+    _Atomic(uint64_t) maxNs;
+}list_histogram_t;
+
+struct list_metrics_t
+{
+    list_histogram_t ops[LIST_OP_COUNT];
+    /* NULL for global metrics */
+    freeData freeFunc;
+};
+
+static list_metrics_t globalMetrics;
+
+static const char* const opNames[LIST_OP_COUNT] =
+{
+    "append",
+    "insert",
+    "getElementAt",
+    "removeElementAt",
+    "freeList"
+};
+
+static const double exportPercentiles[EXPORT_PERCENTILES] = { 50.0, 90.0, 99.0, 99.9 };
+static const char* const exportNames[EXPORT_PERCENTILES] = { "p50", "p90", "p99", "p999" };
+
+static unsigned int bucketOf(uint64_t ns)
+{
+    unsigned int exponent;
+    if ( ns < LIST_METRICS_SUB_BUCKETS )
+    {
+        return (unsigned int)ns;
+    }
+    exponent = 63u - (unsigned int)__builtin_clzll(ns);
+    return ( exponent - 2u ) * LIST_METRICS_SUB_BUCKETS + (unsigned int)( ( ns >> ( exponent - 3u ) ) & ( LIST_METRICS_SUB_BUCKETS - 1u ) );
+}
+
+/* Highest value falling into bucket */
+static uint64_t bucketLimit(unsigned int bucket)
+{
+    unsigned int shift;
+    uint64_t low;
+    if ( bucket < LIST_METRICS_SUB_BUCKETS )
+    {
+        return bucket;
+    }
+    shift = bucket / LIST_METRICS_SUB_BUCKETS - 1u;
+    low = (uint64_t)( LIST_METRICS_SUB_BUCKETS + bucket % LIST_METRICS_SUB_BUCKETS ) << shift;
+    return low + ( ( (uint64_t)1u << shift ) - 1u );
+}
+
+list_error_t listMetrics_newMetrics(list_metrics_t** metrics, freeData freeFunc, allocData allocFunc)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == metrics, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == freeFunc, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == allocFunc, LIST_INVALID_PARAM );
+
+    *metrics = (list_metrics_t*)allocFunc(sizeof(list_metrics_t));
+    if ( NULL == *metrics )
+    {
+        return LIST_NO_MEM;
+    }
+    (*metrics)->freeFunc = freeFunc;
+    return listMetrics_reset(*metrics);
+}
+
+list_error_t listMetrics_freeMetrics(list_metrics_t* metrics)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == metrics, LIST_INVALID_PARAM );
+    /* Global metrics are not allocated */
+    GENERIC_LIST_VALIDATE( NULL == metrics->freeFunc, LIST_INVALID_PARAM );
+
+    metrics->freeFunc(metrics);
+    return LIST_SUCCESS;
+}
+
+list_error_t listMetrics_reset(list_metrics_t* metrics)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == metrics, LIST_INVALID_PARAM );
+
+    for ( unsigned int op = 0; op < LIST_OP_COUNT; op++ )
+    {
+        list_histogram_t* histogram = &metrics->ops[op];
+        for ( unsigned int i = 0; i < LIST_METRICS_BUCKETS; i++ )
+        {
+            atomic_store_explicit(&histogram->buckets[i], 0, memory_order_relaxed);
+        }
+        atomic_store_explicit(&histogram->count, 0, memory_order_relaxed);
+        atomic_store_explicit(&histogram->sumNs, 0, memory_order_relaxed);
+        atomic_store_explicit(&histogram->maxNs, 0, memory_order_relaxed);
+    }
+    return LIST_SUCCESS;
+}
+
+list_metrics_t* listMetrics_global(void)
+{
+    return &globalMetrics;
+}
+
+uint64_t listMetrics_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+list_error_t listMetrics_record(list_metrics_t* metrics, list_op_t op, uint64_t ns)
+{
+    list_histogram_t* histogram;
+    uint64_t max;
+
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == metrics ) || ( op >= LIST_OP_COUNT ), LIST_INVALID_PARAM );
+
+    histogram = &metrics->ops[op];
+    atomic_fetch_add_explicit(&histogram->buckets[bucketOf(ns)], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&histogram->sumNs, ns, memory_order_relaxed);
+    max = atomic_load_explicit(&histogram->maxNs, memory_order_relaxed);
+    while ( ( ns > max ) &&
+            !atomic_compare_exchange_weak_explicit(&histogram->maxNs, &max, ns, memory_order_relaxed, memory_order_relaxed) )
+    {
+    }
+    return LIST_SUCCESS;
+}
+
+list_error_t listMetrics_getStats(list_metrics_t* metrics, list_op_t op, list_op_stats_t* stats)
+{
+    list_histogram_t* histogram;
+
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == metrics ) || ( op >= LIST_OP_COUNT ) || ( NULL == stats ), LIST_INVALID_PARAM );
+
+    histogram = &metrics->ops[op];
+    stats->count = atomic_load_explicit(&histogram->count, memory_order_relaxed);
+    stats->sumNs = atomic_load_explicit(&histogram->sumNs, memory_order_relaxed);
+    stats->maxNs = atomic_load_explicit(&histogram->maxNs, memory_order_relaxed);
+    return LIST_SUCCESS;
+}
+
+list_error_t listMetrics_percentile(list_metrics_t* metrics, list_op_t op, double percentile, uint64_t* ns)
+{
+    list_histogram_t* histogram;
+    uint64_t total = 0;
+    uint64_t target;
+    uint64_t seen = 0;
+
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == metrics ) || ( op >= LIST_OP_COUNT ) || ( NULL == ns ), LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( ( percentile < 0.0 ) || ( percentile > 100.0 ), LIST_INVALID_PARAM );
+
+    /* Sum buckets instead of using count, recording threads may be mid update */
+    histogram = &metrics->ops[op];
+    for ( unsigned int i = 0; i < LIST_METRICS_BUCKETS; i++ )
+    {
+        total += atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+    }
+    if ( 0 == total )
+    {
+        return LIST_EMPTY;
+    }
+    target = (uint64_t)( ( percentile / 100.0 ) * (double)total + 0.5 );
+    if ( 0 == target )
+    {
+        target = 1;
+    }
+    for ( unsigned int i = 0; i < LIST_METRICS_BUCKETS; i++ )
+    {
+        seen += atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+        if ( seen >= target )
+        {
+            uint64_t max = atomic_load_explicit(&histogram->maxNs, memory_order_relaxed);
+            uint64_t limit = bucketLimit(i);
+            *ns = ( limit < max ) ? limit : max;
+            return LIST_SUCCESS;
+        }
+    }
+    *ns = atomic_load_explicit(&histogram->maxNs, memory_order_relaxed);
+    return LIST_SUCCESS;
+}
+
+static void exportText(list_metrics_t* metrics, FILE* out)
+{
+    fprintf(out, "%-16s %12s %12s", "operation", "count", "mean ns");
+    for ( unsigned int p = 0; p < EXPORT_PERCENTILES; p++ )
+    {
+        fprintf(out, " %10s", exportNames[p]);
+    }
+    fprintf(out, " %12s\n", "max ns");
+
+    for ( unsigned int op = 0; op < LIST_OP_COUNT; op++ )
+    {
+        list_histogram_t* histogram = &metrics->ops[op];
+        uint64_t count = atomic_load_explicit(&histogram->count, memory_order_relaxed);
+        uint64_t sum = atomic_load_explicit(&histogram->sumNs, memory_order_relaxed);
+        fprintf(out, "%-16s %12" PRIu64 " %12.1f", opNames[op], count, ( 0 != count ) ? (double)sum / (double)count : 0.0);
+        for ( unsigned int p = 0; p < EXPORT_PERCENTILES; p++ )
+        {
+            uint64_t ns = 0;
+            (void)listMetrics_percentile(metrics, (list_op_t)op, exportPercentiles[p], &ns);
+            fprintf(out, " %10" PRIu64, ns);
+        }
+        fprintf(out, " %12" PRIu64 "\n", atomic_load_explicit(&histogram->maxNs, memory_order_relaxed));
+    }
+}
+
+/* Empty buckets are left out, every bucket is [highest ns, count] */
+static void exportJson(list_metrics_t* metrics, FILE* out)
+{
+    fprintf(out, "{");
+    for ( unsigned int op = 0; op < LIST_OP_COUNT; op++ )
+    {
+        list_histogram_t* histogram = &metrics->ops[op];
+        bool first = true;
+        fprintf(out, "%s\"%s\":{\"count\":%" PRIu64 ",\"sum_ns\":%" PRIu64 ",\"max_ns\":%" PRIu64,
+                ( 0 != op ) ? "," : "", opNames[op],
+                atomic_load_explicit(&histogram->count, memory_order_relaxed),
+                atomic_load_explicit(&histogram->sumNs, memory_order_relaxed),
+                atomic_load_explicit(&histogram->maxNs, memory_order_relaxed));
+        for ( unsigned int p = 0; p < EXPORT_PERCENTILES; p++ )
+        {
+            uint64_t ns = 0;
+            (void)listMetrics_percentile(metrics, (list_op_t)op, exportPercentiles[p], &ns);
+            fprintf(out, ",\"%s_ns\":%" PRIu64, exportNames[p], ns);
+        }
+        fprintf(out, ",\"buckets\":[");
+        for ( unsigned int i = 0; i < LIST_METRICS_BUCKETS; i++ )
+        {
+            uint64_t count = atomic_load_explicit(&histogram->buckets[i], memory_order_relaxed);
+            if ( 0 != count )
+            {
+                fprintf(out, "%s[%" PRIu64 ",%" PRIu64 "]", first ? "" : ",", bucketLimit(i), count);
+                first = false;
+            }
+        }
+        fprintf(out, "]}");
+    }
+    fprintf(out, "}\n");
+}
+
+list_error_t listMetrics_export(list_metrics_t* metrics, list_metrics_format_t format, FILE* out)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == metrics ) || ( NULL == out ), LIST_INVALID_PARAM );
+
+    switch ( format )
+    {
+    case LIST_METRICS_TEXT:
+        exportText(metrics, out);
+        break;
+    case LIST_METRICS_JSON:
+        exportJson(metrics, out);
+        break;
+    default:
+        return LIST_INVALID_PARAM;
+    }
+    return LIST_SUCCESS;
+}
@@ -0,0 +1,166 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file list_metrics.h
+ * @brief Latency histograms of generic list operations
+ *
+ * With generic_list.c built with GENERIC_LIST_INSTRUMENT every append,
+ * insert, positional lookup, removal and freeList records its latency in the
+ * global metrics and in metrics set for the list with genericList_setMetrics.
+ *
+ * Histograms have log-linear buckets: values below 8 ns get a bucket each,
+ * every further power of two is split into 8 buckets, so any recorded value
+ * is known within 12.5%. Recording is lock-free and may happen from any
+ * number of threads.
+ *
+ * Histograms are kept behind an opaque list_metrics_t, so this header can be
+ * used from C++ as well. Use listMetrics_getStats, listMetrics_percentile and
+ * listMetrics_export to read them.
+ *
+ */
+
+#ifndef SRC_TOOLS_LIST_METRICS_H_
+#define SRC_TOOLS_LIST_METRICS_H_
+
+#include "generic_list.h"
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum
+{
+    LIST_OP_APPEND,
+    /** insert, insert64 and insertBefore */
+    LIST_OP_INSERT,
+    /** getElementAt and getDataAt */
+    LIST_OP_GET_ELEMENT_AT,
+    /** removeElementAt and removeElement */
+    LIST_OP_REMOVE_ELEMENT_AT,
+    LIST_OP_FREE_LIST,
+    LIST_OP_COUNT
+}list_op_t;
+
+typedef enum
+{
+    LIST_METRICS_TEXT,
+    LIST_METRICS_JSON
+}list_metrics_format_t;
+
+/** Histograms of all operations, opaque */
+typedef struct list_metrics_t list_metrics_t;
+
+/** Totals of one operation */
+typedef struct
+{
+    uint64_t count;
+    uint64_t sumNs;
+    uint64_t maxNs;
+}list_op_stats_t;
+
+/** @brief Allocate new cleared metrics
+ *
+ * @param[out]  metrics     set to pointer to new metrics
+ * @param[in]   freeFunc    pointer to function used to free memory @ref freeData
+ * @param[in]   allocFunc   pointer to function used to allocate memory @ref allocData
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t listMetrics_newMetrics(list_metrics_t** metrics, freeData freeFunc, allocData allocFunc);
+
+/** @brief Free metrics allocated with listMetrics_newMetrics
+ *         NOTE: lists using them must be given other metrics or NULL first
+ *
+ * @param[in]   metrics   pointer to metrics
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t listMetrics_freeMetrics(list_metrics_t* metrics);
+
+/** @brief Clear all histograms
+ *
+ * @param[in]   metrics   pointer to metrics structure
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t listMetrics_reset(list_metrics_t* metrics);
+
+/** @brief Get metrics all lists record into
+ *
+ * @return pointer to global metrics
+ */
+list_metrics_t* listMetrics_global(void);
+
+/** @brief Get monotonic time used for recording
+ *
+ * @return time in nanoseconds
+ */
+uint64_t listMetrics_now(void);
+
+/** @brief Record latency of an operation
+ *
+ * @param[in]   metrics   pointer to metrics structure
+ * @param[in]   op        operation @ref list_op_t
+ * @param[in]   ns        latency in nanoseconds
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t listMetrics_record(list_metrics_t* metrics, list_op_t op, uint64_t ns);
+
+/** @brief Get number, total and maximum latency of recorded operations
+ *
+ * @param[in]    metrics   pointer to metrics structure
+ * @param[in]    op        operation @ref list_op_t
+ * @param[out]   stats     set to totals of the operation
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t listMetrics_getStats(list_metrics_t* metrics, list_op_t op, list_op_stats_t* stats);
+
+/** @brief Get latency below which given share of operations completed
+ *
+ * @param[in]    metrics      pointer to metrics structure
+ * @param[in]    op           operation @ref list_op_t
+ * @param[in]    percentile   percentile in range 0 - 100
+ * @param[out]   ns           set to upper bound of the bucket holding the percentile
+ *
+ * @return LIST_SUCCESS on success, LIST_EMPTY if nothing was recorded. @ref list_error_t
+ */
+list_error_t listMetrics_percentile(list_metrics_t* metrics, list_op_t op, double percentile, uint64_t* ns);
+
+/** @brief Write all histograms as text table or JSON object
+ *
+ * @param[in]   metrics   pointer to metrics structure
+ * @param[in]   format    output format @ref list_metrics_format_t
+ * @param[in]   out       stream to write to
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t listMetrics_export(list_metrics_t* metrics, list_metrics_format_t format, FILE* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_TOOLS_LIST_METRICS_H_ */
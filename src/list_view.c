@@ -0,0 +1,259 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file list_view.c
+ * @brief Lazy views over generic lists
+ *
+ * Pull based: next on a view pulls from its source until it can produce an
+ * element, so one element travels through the whole pipeline before the
+ * next one is read from the list.
+ *
+ */
+
+#include "list_view.h"
+
+#include <string.h>
+
+static void initView(list_view_t* view, list_view_kind_t kind, list_view_t* source)
+{
+    memset(view, 0, sizeof(*view));
+    view->kind = kind;
+    view->source = source;
+}
+
+/* Unchecked pull, params were validated when the pipeline was built */
+static bool pull(list_view_t* view, void** data)
+{
+    void* first;
+    void* second;
+
+    switch ( view->kind )
+    {
+    case LIST_VIEW_SOURCE:
+    case LIST_VIEW_REVERSE:
+        if ( NULL == view->node )
+        {
+            return false;
+        }
+        *data = view->node->data;
+        view->node = ( LIST_VIEW_SOURCE == view->kind ) ? view->node->next : view->node->prev;
+        return true;
+
+    case LIST_VIEW_FILTER:
+        while ( pull(view->source, data) )
+        {
+            if ( view->func.filterFunc(view->ctx, *data) )
+            {
+                return true;
+            }
+        }
+        return false;
+
+    case LIST_VIEW_MAP:
+        if ( !pull(view->source, data) )
+        {
+            return false;
+        }
+        *data = view->func.mapFunc(view->ctx, *data);
+        return true;
+
+    case LIST_VIEW_TAKE:
+        if ( ( 0 == view->count ) || !pull(view->source, data) )
+        {
+            return false;
+        }
+        view->count--;
+        return true;
+
+    case LIST_VIEW_SKIP:
+        for ( ; 0 != view->count; view->count-- )
+        {
+            if ( !pull(view->source, data) )
+            {
+                return false;
+            }
+        }
+        return pull(view->source, data);
+
+    case LIST_VIEW_ZIP:
+        if ( !pull(view->source, &first) || !pull(view->second, &second) )
+        {
+            return false;
+        }
+        *data = view->func.zipFunc(view->ctx, first, second);
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+list_error_t listView_source(list_view_t* view, generic_list_t* list)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == view ) || ( NULL == list ), LIST_INVALID_PARAM );
+
+    initView(view, LIST_VIEW_SOURCE, NULL);
+    view->node = list->head;
+    return LIST_SUCCESS;
+}
+
+list_error_t listView_reverse(list_view_t* view, generic_list_t* list)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == view ) || ( NULL == list ), LIST_INVALID_PARAM );
+
+    initView(view, LIST_VIEW_REVERSE, NULL);
+    view->node = list->tail;
+    return LIST_SUCCESS;
+}
+
+list_error_t listView_filter(list_view_t* view, list_view_t* source, filterData filterFunc, void* ctx)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == view ) || ( NULL == source ) || ( NULL == filterFunc ), LIST_INVALID_PARAM );
+
+    initView(view, LIST_VIEW_FILTER, source);
+    view->func.filterFunc = filterFunc;
+    view->ctx = ctx;
+    return LIST_SUCCESS;
+}
+
+list_error_t listView_map(list_view_t* view, list_view_t* source, mapData mapFunc, void* ctx)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == view ) || ( NULL == source ) || ( NULL == mapFunc ), LIST_INVALID_PARAM );
+
+    initView(view, LIST_VIEW_MAP, source);
+    view->func.mapFunc = mapFunc;
+    view->ctx = ctx;
+    return LIST_SUCCESS;
+}
+
+list_error_t listView_take(list_view_t* view, list_view_t* source, size_t count)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == view ) || ( NULL == source ), LIST_INVALID_PARAM );
+
+    initView(view, LIST_VIEW_TAKE, source);
+    view->count = count;
+    return LIST_SUCCESS;
+}
+
+list_error_t listView_skip(list_view_t* view, list_view_t* source, size_t count)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == view ) || ( NULL == source ), LIST_INVALID_PARAM );
+
+    initView(view, LIST_VIEW_SKIP, source);
+    view->count = count;
+    return LIST_SUCCESS;
+}
+
+list_error_t listView_zip(list_view_t* view, list_view_t* first, list_view_t* second, zipData zipFunc, void* ctx)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == view ) || ( NULL == first ) || ( NULL == second ), LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( ( NULL == zipFunc ) || ( first == second ), LIST_INVALID_PARAM );
+
+    initView(view, LIST_VIEW_ZIP, first);
+    view->second = second;
+    view->func.zipFunc = zipFunc;
+    view->ctx = ctx;
+    return LIST_SUCCESS;
+}
+
+list_error_t listView_next(list_view_t* view, void** data)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == view ) || ( NULL == data ), LIST_INVALID_PARAM );
+
+    return pull(view, data) ? LIST_SUCCESS : LIST_NOT_FOUND;
+}
+
+list_error_t listView_forEach(list_view_t* view, visitView visitor, void* ctx)
+{
+    void* data;
+
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == view ) || ( NULL == visitor ), LIST_INVALID_PARAM );
+
+    while ( pull(view, &data) )
+    {
+        if ( !visitor(ctx, data) )
+        {
+            break;
+        }
+    }
+    return LIST_SUCCESS;
+}
+
+/* Data reaching the end of the view was produced by a map or zip stage */
+static bool producesData(const list_view_t* view)
+{
+    while ( ( LIST_VIEW_FILTER == view->kind ) || ( LIST_VIEW_TAKE == view->kind ) || ( LIST_VIEW_SKIP == view->kind ) )
+    {
+        view = view->source;
+    }
+    return ( LIST_VIEW_MAP == view->kind ) || ( LIST_VIEW_ZIP == view->kind );
+}
+
+list_error_t listView_collect(list_view_t* view, generic_list_t* list, void** rejected)
+{
+    void* data;
+
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == view ) || ( NULL == list ) || ( NULL == rejected ), LIST_INVALID_PARAM );
+
+    *rejected = NULL;
+    if ( !producesData(view) )
+    {
+        /* Elements are still owned by the source list */
+        return LIST_INVALID_PARAM;
+    }
+    while ( pull(view, &data) )
+    {
+        list_error_t err = genericList_append(list, data);
+        if ( LIST_SUCCESS != err )
+        {
+            /* Hand it back, it is not in the list */
+            *rejected = data;
+            return err;
+        }
+    }
+    return LIST_SUCCESS;
+}
+
+list_error_t listView_count(list_view_t* view, size_t* count)
+{
+    void* data;
+
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == view ) || ( NULL == count ), LIST_INVALID_PARAM );
+
+    *count = 0;
+    while ( pull(view, &data) )
+    {
+        (*count)++;
+    }
+    return LIST_SUCCESS;
+}
@@ -0,0 +1,209 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file list_view.h
+ * @brief Lazy views over generic lists
+ *
+ * A view is a pipeline stage which produces data on demand. Stages are
+ * chained by passing the previous view as source, nothing is evaluated until
+ * elements are pulled with listView_next, listView_forEach or
+ * listView_collect. Every element then passes through all stages in one go,
+ * no intermediate lists are built.
+ *
+ * Views live in caller provided structures, a pipeline allocates no memory
+ * however many stages it has. A view is single pass and must not outlive its
+ * sources. Lists must not be modified while views over them are pulled.
+ *
+ */
+
+#ifndef SRC_TOOLS_LIST_VIEW_H_
+#define SRC_TOOLS_LIST_VIEW_H_
+
+#include "generic_list.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Keep element when true is returned */
+typedef bool (*filterData)(void* ctx, const void* data);
+/** Returns data produced for element */
+typedef void* (*mapData)(void* ctx, void* data);
+/** Returns data produced for pair of elements */
+typedef void* (*zipData)(void* ctx, void* first, void* second);
+/** Visitor, returning false stops the traversal */
+typedef bool (*visitView)(void* ctx, void* data);
+
+typedef enum
+{
+    LIST_VIEW_SOURCE,
+    LIST_VIEW_REVERSE,
+    LIST_VIEW_FILTER,
+    LIST_VIEW_MAP,
+    LIST_VIEW_TAKE,
+    LIST_VIEW_SKIP,
+    LIST_VIEW_ZIP
+}list_view_kind_t;
+
+typedef struct list_view_t
+{
+    list_view_kind_t kind;
+    /* Upstream stages, second is used by zip only */
+    struct list_view_t* source;
+    struct list_view_t* second;
+    /* Position of source and reverse views */
+    generic_list_node_t* node;
+    union
+    {
+        filterData filterFunc;
+        mapData mapFunc;
+        zipData zipFunc;
+    }func;
+    void* ctx;
+    /* Elements left to take or skip */
+    size_t count;
+}list_view_t;
+
+/** @brief Create view over list elements from head to tail
+ *
+ * @param[in]   view   pointer to view structure
+ * @param[in]   list   pointer to list context structure
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t listView_source(list_view_t* view, generic_list_t* list);
+
+/** @brief Create view over list elements from tail to head
+ *
+ * @param[in]   view   pointer to view structure
+ * @param[in]   list   pointer to list context structure
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t listView_reverse(list_view_t* view, generic_list_t* list);
+
+/** @brief Create view producing source elements accepted by filterFunc
+ *
+ * @param[in]   view         pointer to view structure
+ * @param[in]   source       upstream view
+ * @param[in]   filterFunc   predicate @ref filterData
+ * @param[in]   ctx          pointer passed to filterFunc
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t listView_filter(list_view_t* view, list_view_t* source, filterData filterFunc, void* ctx);
+
+/** @brief Create view producing mapFunc results for source elements
+ *         Data returned by mapFunc is passed on as is, the view does not own it
+ *
+ * @param[in]   view      pointer to view structure
+ * @param[in]   source    upstream view
+ * @param[in]   mapFunc   transformation @ref mapData
+ * @param[in]   ctx       pointer passed to mapFunc
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t listView_map(list_view_t* view, list_view_t* source, mapData mapFunc, void* ctx);
+
+/** @brief Create view producing at most count first source elements
+ *         Source is not pulled once count elements were produced
+ *
+ * @param[in]   view     pointer to view structure
+ * @param[in]   source   upstream view
+ * @param[in]   count    maximum number of elements
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t listView_take(list_view_t* view, list_view_t* source, size_t count);
+
+/** @brief Create view dropping count first source elements
+ *
+ * @param[in]   view     pointer to view structure
+ * @param[in]   source   upstream view
+ * @param[in]   count    number of elements to drop
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t listView_skip(list_view_t* view, list_view_t* source, size_t count);
+
+/** @brief Create view combining elements of two views pairwise
+ *         Ends with the shorter of both views
+ *
+ * @param[in]   view      pointer to view structure
+ * @param[in]   first     first upstream view
+ * @param[in]   second    second upstream view
+ * @param[in]   zipFunc   combination @ref zipData
+ * @param[in]   ctx       pointer passed to zipFunc
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t listView_zip(list_view_t* view, list_view_t* first, list_view_t* second, zipData zipFunc, void* ctx);
+
+/** @brief Pull next element through the pipeline
+ *
+ * @param[in]    view   pointer to view structure
+ * @param[out]   data   set to data of the next element
+ *
+ * @return LIST_SUCCESS on success, LIST_NOT_FOUND when view is exhausted. @ref list_error_t
+ */
+list_error_t listView_next(list_view_t* view, void** data);
+
+/** @brief Pull all remaining elements and pass them to visitor
+ *
+ * @param[in]   view      pointer to view structure
+ * @param[in]   visitor   function called for each element @ref visitView
+ * @param[in]   ctx       pointer passed to visitor
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t listView_forEach(list_view_t* view, visitView visitor, void* ctx);
+
+/** @brief Pull all remaining elements and append them to list
+ *         NOTE: view must end in data produced by a map or zip stage, possibly
+ *         followed by filter, take or skip. list takes ownership of collected
+ *         data and frees it with its freeFunc. Elements of source and reverse
+ *         views belong to their list and are rejected with LIST_INVALID_PARAM,
+ *         map them to copies to collect them.
+ *
+ * @param[in]    view       pointer to view structure
+ * @param[in]    list       list the elements are appended to
+ * @param[out]   rejected   set to the pulled element which could not be appended,
+ *                          caller owns it, NULL when there is none
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t listView_collect(list_view_t* view, generic_list_t* list, void** rejected);
+
+/** @brief Pull all remaining elements and count them
+ *
+ * @param[in]    view    pointer to view structure
+ * @param[out]   count   set to number of elements
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t listView_count(list_view_t* view, size_t* count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_TOOLS_LIST_VIEW_H_ */
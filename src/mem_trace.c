@@ -0,0 +1,219 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file mem_trace.c
+ * @brief Memory accounting allocator
+ *
+ * Open addressing table with linear probing, kept at most half full and
+ * doubled when it grows past that. Deletion shifts following entries back
+ * instead of leaving tombstones, so probe sequences stay short.
+ *
+ */
+
+#include "mem_trace.h"
+
+#include <pthread.h>
+
+#define MEM_TRACE_INITIAL_SLOTS     (1024u)
+
+typedef struct
+{
+    void* ptr;
+    size_t size;
+}mem_trace_entry_t;
+
+static pthread_mutex_t traceLock = PTHREAD_MUTEX_INITIALIZER;
+static mem_trace_entry_t* table;
+static size_t tableSlots;
+static mem_trace_stats_t traceStats;
+
+static size_t slotOf(const void* ptr, size_t slots)
+{
+    /* Fibonacci hashing takes the top bits of the product, the low pointer
+     * bits are mostly alignment and mix poorly */
+    unsigned bits = (unsigned)__builtin_ctzll((unsigned long long)slots);
+    return (size_t)( ( (uint64_t)(uintptr_t)ptr * 0x9E3779B97F4A7C15ull ) >> ( 64 - bits ) );
+}
+
+static void insertEntry(mem_trace_entry_t* entries, size_t slots, void* ptr, size_t size)
+{
+    size_t i = slotOf(ptr, slots);
+    traceStats.probes++;
+    while ( NULL != entries[i].ptr )
+    {
+        i = ( i + 1 ) & ( slots - 1 );
+        traceStats.probes++;
+    }
+    entries[i].ptr = ptr;
+    entries[i].size = size;
+}
+
+static bool grow(void)
+{
+    size_t slots = ( 0 == tableSlots ) ? MEM_TRACE_INITIAL_SLOTS : ( tableSlots * 2 );
+    mem_trace_entry_t* entries = (mem_trace_entry_t*)calloc(slots, sizeof(mem_trace_entry_t));
+    if ( NULL == entries )
+    {
+        return false;
+    }
+    for ( size_t i = 0; i < tableSlots; i++ )
+    {
+        if ( NULL != table[i].ptr )
+        {
+            insertEntry(entries, slots, table[i].ptr, table[i].size);
+        }
+    }
+    free(table);
+    table = entries;
+    tableSlots = slots;
+    return true;
+}
+
+/* Remove entry, returns false if pointer is not tracked */
+static bool removeEntry(void* ptr, size_t* size)
+{
+    size_t i;
+    if ( 0 == tableSlots )
+    {
+        return false;
+    }
+    i = slotOf(ptr, tableSlots);
+    traceStats.probes++;
+    while ( ptr != table[i].ptr )
+    {
+        if ( NULL == table[i].ptr )
+        {
+            return false;
+        }
+        i = ( i + 1 ) & ( tableSlots - 1 );
+        traceStats.probes++;
+    }
+    *size = table[i].size;
+
+    /* Shift back following entries which would not be found across the hole */
+    for ( size_t j = ( i + 1 ) & ( tableSlots - 1 ); NULL != table[j].ptr; j = ( j + 1 ) & ( tableSlots - 1 ) )
+    {
+        size_t home = slotOf(table[j].ptr, tableSlots);
+        /* Entry at j may move to hole at i if its home is not in (i, j] */
+        bool inRange = ( i < j ) ? ( ( home > i ) && ( home <= j ) ) : ( ( home > i ) || ( home <= j ) );
+        if ( !inRange )
+        {
+            table[i] = table[j];
+            i = j;
+        }
+    }
+    table[i].ptr = NULL;
+    table[i].size = 0;
+    return true;
+}
+
+void* memTrace_malloc(size_t size)
+{
+    void* ptr = malloc(size);
+    if ( NULL == ptr )
+    {
+        return NULL;
+    }
+    pthread_mutex_lock(&traceLock);
+    if ( ( ( traceStats.liveBlocks + 1 ) * 2 > tableSlots ) && !grow() )
+    {
+        pthread_mutex_unlock(&traceLock);
+        free(ptr);
+        return NULL;
+    }
+    insertEntry(table, tableSlots, ptr, size);
+    traceStats.liveBlocks++;
+    traceStats.allocCount++;
+    traceStats.liveBytes += size;
+    if ( traceStats.liveBytes > traceStats.peakBytes )
+    {
+        traceStats.peakBytes = traceStats.liveBytes;
+    }
+    pthread_mutex_unlock(&traceLock);
+    return ptr;
+}
+
+void memTrace_free(void* ptr)
+{
+    size_t size;
+    bool tracked;
+    if ( NULL == ptr )
+    {
+        return;
+    }
+    pthread_mutex_lock(&traceLock);
+    tracked = removeEntry(ptr, &size);
+    if ( tracked )
+    {
+        traceStats.liveBlocks--;
+        traceStats.freeCount++;
+        traceStats.liveBytes -= size;
+    }
+    else
+    {
+        traceStats.invalidFrees++;
+    }
+    pthread_mutex_unlock(&traceLock);
+    if ( tracked )
+    {
+        free(ptr);
+    }
+}
+
+list_error_t memTrace_getStats(mem_trace_stats_t* stats)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == stats, LIST_INVALID_PARAM );
+
+    pthread_mutex_lock(&traceLock);
+    *stats = traceStats;
+    pthread_mutex_unlock(&traceLock);
+    return LIST_SUCCESS;
+}
+
+list_error_t memTrace_resetPeak(void)
+{
+    pthread_mutex_lock(&traceLock);
+    traceStats.peakBytes = traceStats.liveBytes;
+    pthread_mutex_unlock(&traceLock);
+    return LIST_SUCCESS;
+}
+
+size_t memTrace_reportLeaks(FILE* out)
+{
+    size_t leaks;
+    pthread_mutex_lock(&traceLock);
+    for ( size_t i = 0; i < tableSlots; i++ )
+    {
+        if ( ( NULL != table[i].ptr ) && ( NULL != out ) )
+        {
+            fprintf(out, "leak: %p, %zu bytes\n", table[i].ptr, table[i].size);
+        }
+    }
+    leaks = traceStats.liveBlocks;
+    if ( NULL != out )
+    {
+        fprintf(out, "%zu blocks, %zu bytes live, %zu bytes peak\n", leaks, traceStats.liveBytes, traceStats.peakBytes);
+    }
+    pthread_mutex_unlock(&traceLock);
+    return leaks;
+}
@@ -0,0 +1,99 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file mem_trace.h
+ * @brief Memory accounting allocator
+ *
+ * Drop-in @ref allocData / @ref freeData pair which tracks every live block
+ * in a pointer keyed hash table, so allocation and free stay O(1) with
+ * millions of live blocks. Keeps live and peak byte counts, operation
+ * counters and can report blocks which were never freed.
+ *
+ * Tracker is global and thread safe.
+ *
+ */
+
+#ifndef SRC_TOOLS_MEM_TRACE_H_
+#define SRC_TOOLS_MEM_TRACE_H_
+
+#include "generic_list.h"
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    size_t liveBytes;
+    size_t peakBytes;
+    size_t liveBlocks;
+    size_t allocCount;
+    size_t freeCount;
+    size_t invalidFrees;
+    size_t probes;
+}mem_trace_stats_t;
+
+/** @brief Allocate and track memory block, matches @ref allocData
+ *
+ * @param[in]   size   requested size
+ *
+ * @return pointer to block or NULL
+ */
+void* memTrace_malloc(size_t size);
+
+/** @brief Free tracked memory block, matches @ref freeData
+ *         Untracked pointers are counted as invalid frees and left alone
+ *
+ * @param[in]   ptr   block returned by @ref memTrace_malloc or NULL
+ */
+void memTrace_free(void* ptr);
+
+/** @brief Get tracker counters
+ *
+ * @param[out]   stats   filled with current counters. probes is the total
+ *                       number of hash table slots visited by all operations
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t memTrace_getStats(mem_trace_stats_t* stats);
+
+/** @brief Set peak bytes to current live bytes
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t memTrace_resetPeak(void);
+
+/** @brief Print all live blocks
+ *
+ * @param[in]   out   stream to print to
+ *
+ * @return number of live blocks
+ */
+size_t memTrace_reportLeaks(FILE* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_TOOLS_MEM_TRACE_H_ */
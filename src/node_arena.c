@@ -0,0 +1,152 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file node_arena.c
+ * @brief mmap backed bump allocator for generic list nodes
+ *
+ * Mapping is over-reserved by one huge page and trimmed, so that it starts
+ * on a huge page boundary and the kernel can back it with huge pages.
+ *
+ */
+
+#include "node_arena.h"
+
+#include <sys/mman.h>
+
+static size_t roundUp(size_t value, size_t granularity)
+{
+    return ( value + granularity - 1 ) & ~( granularity - 1 );
+}
+
+list_error_t nodeArena_create(node_arena_t* arena, size_t capacity, freeData destructor)
+{
+    uint8_t* mapping;
+    uint8_t* base;
+    size_t reserved;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == arena, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( 0 == capacity, LIST_INVALID_PARAM );
+
+    capacity = roundUp(capacity, NODE_ARENA_HUGE_PAGE_SIZE);
+    reserved = capacity + NODE_ARENA_HUGE_PAGE_SIZE;
+    mapping = (uint8_t*)mmap(NULL, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if ( MAP_FAILED == mapping )
+    {
+        return LIST_NO_MEM;
+    }
+    /* Trim to huge page aligned region */
+    base = (uint8_t*)roundUp((uintptr_t)mapping, NODE_ARENA_HUGE_PAGE_SIZE);
+    if ( base != mapping )
+    {
+        (void)munmap(mapping, (size_t)( base - mapping ));
+    }
+    if ( ( mapping + reserved ) != ( base + capacity ) )
+    {
+        (void)munmap(base + capacity, (size_t)( ( mapping + reserved ) - ( base + capacity ) ));
+    }
+#if defined(MADV_HUGEPAGE)
+    /* Only a hint, transparent huge pages may be disabled */
+    (void)madvise(base, capacity, MADV_HUGEPAGE);
+#endif
+
+    arena->base = base;
+    arena->capacity = capacity;
+    arena->used = 0;
+    arena->destructor = destructor;
+    return LIST_SUCCESS;
+}
+
+void* nodeArena_alloc(void* ctx, size_t size)
+{
+    node_arena_t* arena = (node_arena_t*)ctx;
+    void* block;
+
+    size = roundUp(size, NODE_ARENA_ALIGNMENT);
+    if ( ( arena->capacity - arena->used ) < size )
+    {
+        return NULL;
+    }
+    block = arena->base + arena->used;
+    arena->used += size;
+    return block;
+}
+
+void nodeArena_free(void* ctx, void* node)
+{
+    (void)ctx;
+    (void)node;
+}
+
+list_error_t nodeArena_attach(node_arena_t* arena, generic_list_t* list)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == arena, LIST_INVALID_PARAM );
+
+    return genericList_setNodeAllocator(list, nodeArena_alloc, nodeArena_free, arena);
+}
+
+list_error_t nodeArena_freeList(node_arena_t* arena, generic_list_t* list)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == arena ) || ( NULL == list ), LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( list->nodeAllocCtx != arena, LIST_INVALID_PARAM );
+
+    if ( NULL != arena->destructor )
+    {
+        for ( generic_list_node_t* node = list->head; NULL != node; node = node->next )
+        {
+            arena->destructor(node->data);
+        }
+    }
+
+    /* Nodes stay in arena until it is reset */
+    list->head = NULL;
+    list->tail = NULL;
+    list->current = NULL;
+    list->size = 0;
+    return LIST_SUCCESS;
+}
+
+list_error_t nodeArena_reset(node_arena_t* arena)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == arena, LIST_INVALID_PARAM );
+
+    /* Pages stay mapped and hot for the next request */
+    arena->used = 0;
+    return LIST_SUCCESS;
+}
+
+list_error_t nodeArena_destroy(node_arena_t* arena)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == arena, LIST_INVALID_PARAM );
+
+    if ( NULL != arena->base )
+    {
+        (void)munmap(arena->base, arena->capacity);
+    }
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->used = 0;
+    return LIST_SUCCESS;
+}
@@ -0,0 +1,128 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file node_arena.h
+ * @brief mmap backed bump allocator for generic list nodes
+ *
+ * Arena reserves one contiguous mapping, asks for transparent huge pages and
+ * hands out nodes by bumping an offset. Nodes are never freed one by one,
+ * lists using the arena are dropped in O(1) and the whole arena is reset at
+ * once, which suits lists living exactly as long as a single request.
+ *
+ * Arena is not thread safe.
+ *
+ */
+
+#ifndef SRC_TOOLS_NODE_ARENA_H_
+#define SRC_TOOLS_NODE_ARENA_H_
+
+#include "generic_list.h"
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Mapping granularity, arena is aligned and sized to it */
+#define NODE_ARENA_HUGE_PAGE_SIZE   ((size_t)2u * 1024u * 1024u)
+/** Alignment of allocated nodes */
+#define NODE_ARENA_ALIGNMENT        (sizeof(void*))
+
+typedef struct
+{
+    uint8_t* base;
+    size_t capacity;
+    size_t used;
+    freeData destructor;
+}node_arena_t;
+
+/** @brief Map new arena
+ *
+ * @param[in]   arena        pointer to arena context structure
+ * @param[in]   capacity     arena size in bytes, rounded up to NODE_ARENA_HUGE_PAGE_SIZE
+ * @param[in]   destructor   called for data of every element when a list is dropped
+ *                           with @ref nodeArena_freeList, NULL skips the pass
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t nodeArena_create(node_arena_t* arena, size_t capacity, freeData destructor);
+
+/** @brief Allocate node from arena, matches @ref allocNode
+ *
+ * @param[in]   ctx    pointer to arena context structure
+ * @param[in]   size   requested size
+ *
+ * @return pointer to block or NULL if arena is exhausted
+ */
+void* nodeArena_alloc(void* ctx, size_t size);
+
+/** @brief Single node free, matches @ref freeNode. Does nothing,
+ *         memory is reclaimed by @ref nodeArena_reset
+ *
+ * @param[in]   ctx    pointer to arena context structure
+ * @param[in]   node   block allocated from arena
+ */
+void nodeArena_free(void* ctx, void* node);
+
+/** @brief Allocate nodes of list from arena
+ *         Must be called while the list is empty
+ *
+ * @param[in]   arena   pointer to arena context structure
+ * @param[in]   list    pointer to list context structure
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t nodeArena_attach(node_arena_t* arena, generic_list_t* list);
+
+/** @brief Drop all elements of list allocated from arena
+ *         O(1) unless arena has a destructor, nodes are not freed one by one
+ *
+ * @param[in]   arena   pointer to arena context structure
+ * @param[in]   list    pointer to list context structure
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t nodeArena_freeList(node_arena_t* arena, generic_list_t* list);
+
+/** @brief Make whole arena available again in O(1)
+ *         Lists using the arena must be dropped before
+ *
+ * @param[in]   arena   pointer to arena context structure
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t nodeArena_reset(node_arena_t* arena);
+
+/** @brief Unmap arena
+ *
+ * @param[in]   arena   pointer to arena context structure
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t nodeArena_destroy(node_arena_t* arena);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_TOOLS_NODE_ARENA_H_ */
@@ -0,0 +1,328 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file node_cache.c
+ * @brief Per-thread node cache for generic list
+ *
+ * Thread cache holds "loaded" and "previous" magazines. Allocation pops from
+ * loaded, swaps the two when loaded is empty and previous is not, and only
+ * then trades an empty magazine for a filled one from the depot. Free mirrors
+ * it with full magazines. Keeping two magazines prevents depot round trips
+ * when a thread oscillates around a magazine boundary.
+ *
+ */
+
+#include "node_cache.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+typedef struct magazine_t
+{
+    struct magazine_t* next;
+    unsigned int count;
+    void* blocks[NODE_CACHE_MAGAZINE_SIZE];
+}magazine_t;
+
+typedef struct
+{
+    magazine_t* loaded;
+    magazine_t* previous;
+    bool registered;
+}thread_cache_t;
+
+typedef struct
+{
+    pthread_mutex_t lock;
+    magazine_t* filled;
+    magazine_t* empty;
+    size_t filledCount;
+    size_t emptyCount;
+}depot_t;
+
+static _Thread_local thread_cache_t threadCache;
+
+static depot_t depot = { PTHREAD_MUTEX_INITIALIZER, NULL, NULL, 0, 0 };
+
+static pthread_once_t exitKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t exitKey;
+
+static _Atomic(size_t) systemAllocs;
+static _Atomic(size_t) systemFrees;
+static _Atomic(size_t) depotExchanges;
+
+static void* systemAlloc(void)
+{
+    void* block = malloc(NODE_CACHE_BLOCK_SIZE);
+    if ( NULL != block )
+    {
+        atomic_fetch_add_explicit(&systemAllocs, 1, memory_order_relaxed);
+    }
+    return block;
+}
+
+static void systemFree(void* block)
+{
+    atomic_fetch_add_explicit(&systemFrees, 1, memory_order_relaxed);
+    free(block);
+}
+
+/* Give magazine to depot, depot lock must be held. Returns surplus magazine to release */
+static magazine_t* depotPut(magazine_t* magazine)
+{
+    if ( ( depot.filledCount + depot.emptyCount ) >= NODE_CACHE_DEPOT_LIMIT )
+    {
+        return magazine;
+    }
+    if ( 0 == magazine->count )
+    {
+        magazine->next = depot.empty;
+        depot.empty = magazine;
+        depot.emptyCount++;
+    }
+    else
+    {
+        magazine->next = depot.filled;
+        depot.filled = magazine;
+        depot.filledCount++;
+    }
+    return NULL;
+}
+
+static void releaseMagazine(magazine_t* magazine)
+{
+    for ( unsigned int i = 0; i < magazine->count; i++ )
+    {
+        systemFree(magazine->blocks[i]);
+    }
+    free(magazine);
+}
+
+static void threadExit(void* arg)
+{
+    (void)arg;
+    nodeCache_flushThread();
+}
+
+static void createExitKey(void)
+{
+    (void)pthread_key_create(&exitKey, threadExit);
+}
+
+/* Make sure thread cache is flushed when thread exits */
+static void registerThread(thread_cache_t* cache)
+{
+    if ( !cache->registered )
+    {
+        (void)pthread_once(&exitKeyOnce, createExitKey);
+        (void)pthread_setspecific(exitKey, cache);
+        cache->registered = true;
+    }
+}
+
+/* Trade previous magazine for one with blocks (alloc) or without them (free) */
+static bool depotExchange(thread_cache_t* cache, bool wantFilled)
+{
+    magazine_t* surplus = NULL;
+    magazine_t* taken;
+
+    pthread_mutex_lock(&depot.lock);
+    if ( wantFilled )
+    {
+        taken = depot.filled;
+        if ( NULL != taken )
+        {
+            depot.filled = taken->next;
+            depot.filledCount--;
+        }
+    }
+    else
+    {
+        taken = depot.empty;
+        if ( NULL != taken )
+        {
+            depot.empty = taken->next;
+            depot.emptyCount--;
+        }
+    }
+    if ( ( NULL != taken ) && ( NULL != cache->previous ) )
+    {
+        surplus = depotPut(cache->previous);
+    }
+    pthread_mutex_unlock(&depot.lock);
+
+    if ( NULL == taken )
+    {
+        if ( wantFilled )
+        {
+            return false;
+        }
+        /* No empty magazine in depot, make one */
+        taken = (magazine_t*)malloc(sizeof(magazine_t));
+        if ( NULL == taken )
+        {
+            return false;
+        }
+        taken->count = 0;
+        if ( NULL != cache->previous )
+        {
+            pthread_mutex_lock(&depot.lock);
+            surplus = depotPut(cache->previous);
+            pthread_mutex_unlock(&depot.lock);
+        }
+    }
+    if ( NULL != surplus )
+    {
+        releaseMagazine(surplus);
+    }
+    atomic_fetch_add_explicit(&depotExchanges, 1, memory_order_relaxed);
+
+    cache->previous = cache->loaded;
+    cache->loaded = taken;
+    return true;
+}
+
+void* nodeCache_alloc(void* ctx, size_t size)
+{
+    thread_cache_t* cache = &threadCache;
+    (void)ctx;
+
+    if ( size > NODE_CACHE_BLOCK_SIZE )
+    {
+        return NULL;
+    }
+    if ( ( NULL != cache->loaded ) && ( cache->loaded->count > 0 ) )
+    {
+        return cache->loaded->blocks[--cache->loaded->count];
+    }
+    if ( ( NULL != cache->previous ) && ( cache->previous->count > 0 ) )
+    {
+        magazine_t* tmp = cache->loaded;
+        cache->loaded = cache->previous;
+        cache->previous = tmp;
+        return cache->loaded->blocks[--cache->loaded->count];
+    }
+    registerThread(cache);
+    if ( depotExchange(cache, true) )
+    {
+        return cache->loaded->blocks[--cache->loaded->count];
+    }
+    /* Depot is empty as well */
+    return systemAlloc();
+}
+
+void nodeCache_free(void* ctx, void* node)
+{
+    thread_cache_t* cache = &threadCache;
+    (void)ctx;
+
+    if ( NULL == node )
+    {
+        return;
+    }
+    if ( ( NULL != cache->loaded ) && ( cache->loaded->count < NODE_CACHE_MAGAZINE_SIZE ) )
+    {
+        cache->loaded->blocks[cache->loaded->count++] = node;
+        return;
+    }
+    if ( ( NULL != cache->previous ) && ( cache->previous->count < NODE_CACHE_MAGAZINE_SIZE ) )
+    {
+        magazine_t* tmp = cache->loaded;
+        cache->loaded = cache->previous;
+        cache->previous = tmp;
+        cache->loaded->blocks[cache->loaded->count++] = node;
+        return;
+    }
+    registerThread(cache);
+    if ( depotExchange(cache, false) )
+    {
+        cache->loaded->blocks[cache->loaded->count++] = node;
+        return;
+    }
+    /* Out of memory for magazines */
+    systemFree(node);
+}
+
+list_error_t nodeCache_attach(generic_list_t* list)
+{
+    return genericList_setNodeAllocator(list, nodeCache_alloc, nodeCache_free, NULL);
+}
+
+void nodeCache_flushThread(void)
+{
+    thread_cache_t* cache = &threadCache;
+    magazine_t* magazines[2] = { cache->loaded, cache->previous };
+
+    cache->loaded = NULL;
+    cache->previous = NULL;
+    for ( unsigned int i = 0; i < 2; i++ )
+    {
+        magazine_t* surplus;
+        if ( NULL == magazines[i] )
+        {
+            continue;
+        }
+        pthread_mutex_lock(&depot.lock);
+        surplus = depotPut(magazines[i]);
+        pthread_mutex_unlock(&depot.lock);
+        if ( NULL != surplus )
+        {
+            releaseMagazine(surplus);
+        }
+    }
+}
+
+void nodeCache_trim(void)
+{
+    magazine_t* magazines[2];
+
+    pthread_mutex_lock(&depot.lock);
+    magazines[0] = depot.filled;
+    magazines[1] = depot.empty;
+    depot.filled = NULL;
+    depot.empty = NULL;
+    depot.filledCount = 0;
+    depot.emptyCount = 0;
+    pthread_mutex_unlock(&depot.lock);
+
+    for ( unsigned int i = 0; i < 2; i++ )
+    {
+        magazine_t* magazine = magazines[i];
+        while ( NULL != magazine )
+        {
+            magazine_t* next = magazine->next;
+            releaseMagazine(magazine);
+            magazine = next;
+        }
+    }
+}
+
+list_error_t nodeCache_getStats(node_cache_stats_t* stats)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == stats, LIST_INVALID_PARAM );
+
+    stats->systemAllocs = atomic_load_explicit(&systemAllocs, memory_order_relaxed);
+    stats->systemFrees = atomic_load_explicit(&systemFrees, memory_order_relaxed);
+    stats->depotExchanges = atomic_load_explicit(&depotExchanges, memory_order_relaxed);
+    return LIST_SUCCESS;
+}
@@ -0,0 +1,106 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file node_cache.h
+ * @brief Per-thread node cache for generic list
+ *
+ * Magazine allocator for @ref generic_list_node_t blocks. Every thread keeps
+ * two bounded magazines of free blocks and serves node allocations from them
+ * without locking. Magazines are exchanged in whole with a shared depot, so
+ * the depot lock is taken once per NODE_CACHE_MAGAZINE_SIZE operations at most.
+ *
+ * Blocks do not belong to any thread, a node may be freed by a different
+ * thread than the one which allocated it, it simply lands in the freeing
+ * thread cache. Thread caches are returned to the depot on thread exit.
+ *
+ */
+
+#ifndef SRC_TOOLS_NODE_CACHE_H_
+#define SRC_TOOLS_NODE_CACHE_H_
+
+#include "generic_list.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Size of blocks handed out by the cache */
+#define NODE_CACHE_BLOCK_SIZE       (sizeof(generic_list_node_t))
+/** Number of blocks held by one magazine */
+#define NODE_CACHE_MAGAZINE_SIZE    (64)
+/** Maximum number of magazines kept in the depot, surplus goes back to the system */
+#define NODE_CACHE_DEPOT_LIMIT      (256)
+
+typedef struct
+{
+    size_t systemAllocs;
+    size_t systemFrees;
+    size_t depotExchanges;
+}node_cache_stats_t;
+
+/** @brief Allocate node block, matches @ref allocNode
+ *
+ * @param[in]   ctx    unused, cache is shared by all lists
+ * @param[in]   size   requested size, must not exceed NODE_CACHE_BLOCK_SIZE
+ *
+ * @return pointer to block or NULL
+ */
+void* nodeCache_alloc(void* ctx, size_t size);
+
+/** @brief Free node block, matches @ref freeNode
+ *
+ * @param[in]   ctx    unused, cache is shared by all lists
+ * @param[in]   node   block returned by @ref nodeCache_alloc, from any thread
+ */
+void nodeCache_free(void* ctx, void* node);
+
+/** @brief Allocate nodes of list from node cache
+ *         Must be called while the list is empty
+ *
+ * @param[in]   list   pointer to list context structure
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t nodeCache_attach(generic_list_t* list);
+
+/** @brief Return calling thread magazines to the depot
+ *         Done automatically on thread exit
+ */
+void nodeCache_flushThread(void);
+
+/** @brief Return all blocks held by the depot to the system
+ */
+void nodeCache_trim(void);
+
+/** @brief Get cache counters
+ *
+ * @param[out]   stats   filled with counters since program start
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t nodeCache_getStats(node_cache_stats_t* stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_TOOLS_NODE_CACHE_H_ */
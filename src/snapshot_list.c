@@ -0,0 +1,410 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file snapshot_list.c
+ * @brief Generic list with O(1) read-only snapshots
+ *
+ * Node with bornEpoch b and diedEpoch d is visible to snapshot taken at epoch
+ * e when b <= e < d. Writer stores node fields first and publishes them by
+ * advancing list epoch, readers load the epoch before walking the list.
+ *
+ * Reclamation runs in two steps. Removed node is unlinked once the oldest held
+ * snapshot is not older than its diedEpoch, then the epoch is advanced and the
+ * node is freed once the oldest held snapshot is not older than that epoch,
+ * as only snapshots taken before unlinking could still be walking over it.
+ *
+ */
+
+#include "snapshot_list.h"
+
+/** Free snapshot slot marker, list epochs start from 1 */
+#define SNAPSHOT_SLOT_FREE      (0u)
+/** diedEpoch of nodes which were not removed */
+#define SNAPSHOT_ALIVE          (UINT64_MAX)
+
+static bool isVisible(const snapshot_list_node_t* node, uint64_t epoch)
+{
+    return ( node->bornEpoch <= epoch ) &&
+           ( atomic_load_explicit(&((snapshot_list_node_t*)node)->diedEpoch, memory_order_relaxed) > epoch );
+}
+
+/* First node visible in snapshot starting from node */
+static snapshot_list_node_t* skipInvisible(snapshot_list_node_t* node, uint64_t epoch)
+{
+    while ( ( NULL != node ) && !isVisible(node, epoch) )
+    {
+        node = atomic_load_explicit(&node->next, memory_order_acquire);
+    }
+    return node;
+}
+
+/* Publish new version, must be sequentially consistent with snapshot registration */
+static uint64_t advanceEpoch(snapshot_list_t* list)
+{
+    uint64_t epoch = atomic_load_explicit(&list->epoch, memory_order_relaxed) + 1;
+    atomic_store(&list->epoch, epoch);
+    return epoch;
+}
+
+/* Epoch of the oldest held snapshot, UINT64_MAX if there is none */
+static uint64_t oldestSnapshot(snapshot_list_t* list)
+{
+    uint64_t oldest = UINT64_MAX;
+    for ( unsigned int i = 0; i < SNAPSHOT_LIST_MAX_SNAPSHOTS; i++ )
+    {
+        uint64_t epoch = atomic_load(&list->snapshots[i]);
+        if ( ( SNAPSHOT_SLOT_FREE != epoch ) && ( epoch < oldest ) )
+        {
+            oldest = epoch;
+        }
+    }
+    return oldest;
+}
+
+/* Unlink node from physical list, prev is NULL for head */
+static void unlinkNode(snapshot_list_t* list, snapshot_list_node_t* prev, snapshot_list_node_t* node)
+{
+    snapshot_list_node_t* next = atomic_load_explicit(&node->next, memory_order_relaxed);
+    if ( NULL == prev )
+    {
+        atomic_store_explicit(&list->head, next, memory_order_release);
+    }
+    else
+    {
+        atomic_store_explicit(&prev->next, next, memory_order_release);
+    }
+    if ( list->tail == node )
+    {
+        list->tail = prev;
+    }
+    /* Walkers which are on it may still follow its next pointer, retire it in unlinking order */
+    node->retiredNext = NULL;
+    if ( NULL == list->retiredTail )
+    {
+        list->retired = node;
+    }
+    else
+    {
+        list->retiredTail->retiredNext = node;
+    }
+    list->retiredTail = node;
+    list->deadLinked--;
+}
+
+static void destroyNode(snapshot_list_t* list, snapshot_list_node_t* node)
+{
+    list->freeFunc(node->data);
+    list->freeFunc(node);
+}
+
+list_error_t snapshotList_newList(snapshot_list_t* list, freeData freeFunc, allocData allocFunc)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == freeFunc, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == allocFunc, LIST_INVALID_PARAM );
+
+    atomic_init(&list->head, NULL);
+    atomic_init(&list->epoch, 1);
+    for ( unsigned int i = 0; i < SNAPSHOT_LIST_MAX_SNAPSHOTS; i++ )
+    {
+        atomic_init(&list->snapshots[i], SNAPSHOT_SLOT_FREE);
+    }
+    list->tail = NULL;
+    list->retired = NULL;
+    list->retiredTail = NULL;
+    list->size = 0;
+    list->deadLinked = 0;
+    list->lastCollectEpoch = UINT64_MAX;
+    list->freeFunc = freeFunc;
+    list->allocFunc = allocFunc;
+    return LIST_SUCCESS;
+}
+
+list_error_t snapshotList_append(snapshot_list_t* list, void* data)
+{
+    snapshot_list_node_t* newNode;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+
+    newNode = (snapshot_list_node_t*)list->allocFunc(sizeof(snapshot_list_node_t));
+    if ( NULL == newNode )
+    {
+        return LIST_NO_MEM;
+    }
+    /* Init new node, visible from next epoch on */
+    newNode->data = data;
+    newNode->bornEpoch = atomic_load_explicit(&list->epoch, memory_order_relaxed) + 1;
+    newNode->unlinkEpoch = 0;
+    newNode->retiredNext = NULL;
+    atomic_init(&newNode->next, NULL);
+    atomic_init(&newNode->diedEpoch, SNAPSHOT_ALIVE);
+
+    if ( NULL == list->tail )
+    {
+        atomic_store_explicit(&list->head, newNode, memory_order_release);
+    }
+    else
+    {
+        atomic_store_explicit(&list->tail->next, newNode, memory_order_release);
+    }
+    list->tail = newNode;
+    list->size++;
+    (void)advanceEpoch(list);
+
+    return snapshotList_reclaim(list);
+}
+
+list_error_t snapshotList_removeElementAt(snapshot_list_t* list, size_t index)
+{
+    snapshot_list_node_t* prev = NULL;
+    snapshot_list_node_t* node;
+    uint64_t epoch;
+    uint64_t oldest;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( list->size <= index, LIST_INVALID_PARAM );
+
+    /* Find element in current version, removed elements may still be linked */
+    node = atomic_load_explicit(&list->head, memory_order_relaxed);
+    while ( NULL != node )
+    {
+        if ( SNAPSHOT_ALIVE == atomic_load_explicit(&node->diedEpoch, memory_order_relaxed) )
+        {
+            if ( 0 == index )
+            {
+                break;
+            }
+            index--;
+        }
+        prev = node;
+        node = atomic_load_explicit(&node->next, memory_order_relaxed);
+    }
+    if ( NULL == node )
+    {
+        return LIST_INTERNAL_ERROR;
+    }
+
+    epoch = atomic_load_explicit(&list->epoch, memory_order_relaxed) + 1;
+    atomic_store_explicit(&node->diedEpoch, epoch, memory_order_relaxed);
+    list->size--;
+    list->deadLinked++;
+    (void)advanceEpoch(list);
+
+    oldest = oldestSnapshot(list);
+    if ( oldest >= epoch )
+    {
+        /* No snapshot can see it, unlink right away */
+        unlinkNode(list, prev, node);
+        node->unlinkEpoch = advanceEpoch(list);
+    }
+    else if ( oldest < list->lastCollectEpoch )
+    {
+        /* Collect it as soon as oldest snapshot moves past current one */
+        list->lastCollectEpoch = oldest;
+    }
+
+    return snapshotList_reclaim(list);
+}
+
+list_error_t snapshotList_reclaim(snapshot_list_t* list)
+{
+    uint64_t oldest;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+
+    if ( ( 0 == list->deadLinked ) && ( NULL == list->retired ) )
+    {
+        /* Nothing to reclaim */
+        return LIST_SUCCESS;
+    }
+    oldest = oldestSnapshot(list);
+
+    /* Unlink removed nodes, only worth a walk when oldest snapshot moved on */
+    if ( ( list->deadLinked > 0 ) && ( oldest > list->lastCollectEpoch ) )
+    {
+        snapshot_list_node_t* prev = NULL;
+        snapshot_list_node_t* node = atomic_load_explicit(&list->head, memory_order_relaxed);
+        snapshot_list_node_t* lastRetired = list->retiredTail;
+        while ( NULL != node )
+        {
+            snapshot_list_node_t* next = atomic_load_explicit(&node->next, memory_order_relaxed);
+            uint64_t died = atomic_load_explicit(&node->diedEpoch, memory_order_relaxed);
+            if ( ( SNAPSHOT_ALIVE != died ) && ( died <= oldest ) )
+            {
+                unlinkNode(list, prev, node);
+            }
+            else
+            {
+                prev = node;
+            }
+            node = next;
+        }
+        list->lastCollectEpoch = oldest;
+        if ( lastRetired != list->retiredTail )
+        {
+            uint64_t epoch = advanceEpoch(list);
+            node = ( NULL == lastRetired ) ? list->retired : lastRetired->retiredNext;
+            for ( ; NULL != node; node = node->retiredNext )
+            {
+                node->unlinkEpoch = epoch;
+            }
+            oldest = oldestSnapshot(list);
+        }
+    }
+
+    /* Free nodes nobody can be walking over anymore, oldest unlinked come first */
+    while ( ( NULL != list->retired ) && ( list->retired->unlinkEpoch <= oldest ) )
+    {
+        snapshot_list_node_t* node = list->retired;
+        list->retired = node->retiredNext;
+        destroyNode(list, node);
+    }
+    if ( NULL == list->retired )
+    {
+        list->retiredTail = NULL;
+    }
+    return LIST_SUCCESS;
+}
+
+list_error_t snapshotList_freeList(snapshot_list_t* list)
+{
+    snapshot_list_node_t* node;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    if ( UINT64_MAX != oldestSnapshot(list) )
+    {
+        return LIST_INVALID_PARAM;
+    }
+
+    node = atomic_load_explicit(&list->head, memory_order_relaxed);
+    while ( NULL != node )
+    {
+        snapshot_list_node_t* next = atomic_load_explicit(&node->next, memory_order_relaxed);
+        destroyNode(list, node);
+        node = next;
+    }
+    node = list->retired;
+    while ( NULL != node )
+    {
+        snapshot_list_node_t* next = node->retiredNext;
+        destroyNode(list, node);
+        node = next;
+    }
+
+    atomic_store(&list->head, NULL);
+    list->tail = NULL;
+    list->retired = NULL;
+    list->retiredTail = NULL;
+    list->size = 0;
+    list->deadLinked = 0;
+    list->lastCollectEpoch = UINT64_MAX;
+    return LIST_SUCCESS;
+}
+
+list_error_t snapshotList_snapshot(snapshot_list_t* list, snapshot_list_view_t* view)
+{
+    uint64_t epoch;
+    uint64_t published;
+    unsigned int slot;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == list ) || ( NULL == view ), LIST_INVALID_PARAM );
+
+    /* Claim free slot with current epoch */
+    epoch = atomic_load(&list->epoch);
+    for ( slot = 0; slot < SNAPSHOT_LIST_MAX_SNAPSHOTS; slot++ )
+    {
+        uint64_t expected = SNAPSHOT_SLOT_FREE;
+        if ( atomic_compare_exchange_strong(&list->snapshots[slot], &expected, epoch) )
+        {
+            break;
+        }
+    }
+    if ( SNAPSHOT_LIST_MAX_SNAPSHOTS == slot )
+    {
+        return LIST_NO_MEM;
+    }
+    /* Writer may have advanced past the epoch before it saw our slot, retry until stable */
+    published = atomic_load(&list->epoch);
+    while ( published != epoch )
+    {
+        epoch = published;
+        atomic_store(&list->snapshots[slot], epoch);
+        published = atomic_load(&list->epoch);
+    }
+
+    view->list = list;
+    view->epoch = epoch;
+    view->slot = slot;
+    return snapshotList_rewind(view);
+}
+
+list_error_t snapshotList_release(snapshot_list_view_t* view)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == view ) || ( NULL == view->list ), LIST_INVALID_PARAM );
+
+    atomic_store(&view->list->snapshots[view->slot], SNAPSHOT_SLOT_FREE);
+    view->list = NULL;
+    view->current = NULL;
+    return LIST_SUCCESS;
+}
+
+list_error_t snapshotList_rewind(snapshot_list_view_t* view)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == view ) || ( NULL == view->list ), LIST_INVALID_PARAM );
+
+    view->current = skipInvisible(atomic_load_explicit(&view->list->head, memory_order_acquire), view->epoch);
+    return LIST_SUCCESS;
+}
+
+list_error_t snapshotList_next(snapshot_list_view_t* view)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == view, LIST_INVALID_PARAM );
+    if ( NULL == view->current )
+    {
+        return LIST_NOT_FOUND;
+    }
+    view->current = skipInvisible(atomic_load_explicit(&view->current->next, memory_order_acquire), view->epoch);
+    return LIST_SUCCESS;
+}
+
+bool snapshotList_isAtEnd(snapshot_list_view_t* view)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == view, false );
+    return ( NULL == view->current );
+}
+
+list_error_t snapshotList_getCurrentData(snapshot_list_view_t* view, void** data)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == view ) || ( NULL == data ), LIST_INVALID_PARAM );
+    if ( NULL == view->current )
+    {
+        return LIST_NOT_FOUND;
+    }
+    *data = view->current->data;
+    return LIST_SUCCESS;
+}
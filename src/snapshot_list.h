@@ -0,0 +1,198 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file snapshot_list.h
+ * @brief Generic list with O(1) read-only snapshots
+ *
+ * Variant of generic list which can be scanned by readers through frozen
+ * snapshots while a writer keeps mutating it. Every node records the epoch
+ * in which it was appended and removed, a snapshot is just a registered epoch
+ * and sees the list exactly as it was at that point. Readers never block
+ * writers and never take locks.
+ *
+ * Removed nodes stay linked until no snapshot can see them, then they are
+ * unlinked and freed once every snapshot which may still be walking over
+ * them is released (epoch based reclamation).
+ *
+ * This is a separate list type rather than a snapshot entry point on
+ * generic_list_t: every node needs its epochs and atomic links, which
+ * generic lists do not carry, so lists which need snapshots have to be
+ * created and changed through this API instead of genericList_*.
+ *
+ * Writing functions (append, removeElementAt, reclaim, freeList) must be
+ * serialised by the caller, there is a single writer at a time. Snapshot
+ * functions may be called from any number of threads concurrently with the
+ * writer. At most SNAPSHOT_LIST_MAX_SNAPSHOTS snapshots may be held at once,
+ * snapshotList_snapshot returns LIST_NO_MEM while all slots are in use.
+ *
+ */
+
+#ifndef SRC_TOOLS_SNAPSHOT_LIST_H_
+#define SRC_TOOLS_SNAPSHOT_LIST_H_
+
+#include "generic_list.h"
+
+#include <stdatomic.h>
+
+/* Structures below use C11 _Atomic members which C++ can not declare */
+#ifdef __cplusplus
+#error "snapshot_list.h is C only"
+#endif
+
+/** Maximum number of snapshots held at the same time */
+#define SNAPSHOT_LIST_MAX_SNAPSHOTS     (64)
+
+typedef struct snapshot_list_node_t
+{
+    void* data;
+    _Atomic(struct snapshot_list_node_t*) next;
+    uint64_t bornEpoch;
+    _Atomic(uint64_t) diedEpoch;
+    uint64_t unlinkEpoch;
+    struct snapshot_list_node_t* retiredNext;
+}snapshot_list_node_t;
+
+typedef struct
+{
+    _Atomic(snapshot_list_node_t*) head;
+    _Atomic(uint64_t) epoch;
+    _Atomic(uint64_t) snapshots[SNAPSHOT_LIST_MAX_SNAPSHOTS];
+    /* Writer side state */
+    snapshot_list_node_t* tail;
+    snapshot_list_node_t* retired;
+    snapshot_list_node_t* retiredTail;
+    size_t size;
+    size_t deadLinked;
+    uint64_t lastCollectEpoch;
+    freeData freeFunc;
+    allocData allocFunc;
+}snapshot_list_t;
+
+typedef struct
+{
+    snapshot_list_t* list;
+    snapshot_list_node_t* current;
+    uint64_t epoch;
+    unsigned int slot;
+}snapshot_list_view_t;
+
+/** @brief Create new snapshot list
+ *
+ * @param[in]   list        pointer to list context structure
+ * @param[in]   freeFunc    pointer to function used to free memory @ref freeData
+ * @param[in]   allocFunc   pointer to function used to allocate memory @ref allocData
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t snapshotList_newList(snapshot_list_t* list, freeData freeFunc, allocData allocFunc);
+
+/** @brief Append list with new element (writer)
+ *
+ * @param[in]   list   pointer to list context structure
+ * @param[in]   data   pointer to data that will be stored in the list
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t snapshotList_append(snapshot_list_t* list, void* data);
+
+/** @brief Remove element at given index (writer)
+ *         NOTE: Data is freed once no snapshot can see the element anymore
+ *
+ * @param[in]   list    pointer to list context structure
+ * @param[in]   index   index of element in the current version of the list
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t snapshotList_removeElementAt(snapshot_list_t* list, size_t index);
+
+/** @brief Unlink and free removed elements no longer visible to any snapshot (writer)
+ *         Called implicitly by append and removeElementAt
+ *
+ * @param[in]   list   pointer to list context structure
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t snapshotList_reclaim(snapshot_list_t* list);
+
+/** @brief Free list and its elements (writer)
+ *         NOTE: Data stored in the list will also be freed!
+ *
+ * @param[in]   list   pointer to list context structure
+ *
+ * @return LIST_SUCCESS on success, LIST_INVALID_PARAM if snapshots are still held,
+ *         error code otherwise. @ref list_error_t
+ */
+list_error_t snapshotList_freeList(snapshot_list_t* list);
+
+/** @brief Take read-only snapshot of current list version in O(1)
+ *         Snapshot is positioned at its first element
+ *
+ * @param[in]    list   pointer to list context structure
+ * @param[out]   view   snapshot context
+ *
+ * @return LIST_SUCCESS on success, LIST_NO_MEM if too many snapshots are held,
+ *         error code otherwise. @ref list_error_t
+ */
+list_error_t snapshotList_snapshot(snapshot_list_t* list, snapshot_list_view_t* view);
+
+/** @brief Release snapshot, elements only it could see may be reclaimed afterwards
+ *
+ * @param[in]   view   snapshot context
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t snapshotList_release(snapshot_list_view_t* view);
+
+/** @brief Set currently selected snapshot element as its first element
+ *
+ * @param[in]   view   snapshot context
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t snapshotList_rewind(snapshot_list_view_t* view);
+
+/** @brief Move currently selected snapshot element pointer to next
+ *
+ * @param[in]   view   snapshot context
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t snapshotList_next(snapshot_list_view_t* view);
+
+/** @brief Check if snapshot iteration has ended
+ *
+ * @param[in]   view   snapshot context
+ *
+ * @return true if there are no more elements
+ */
+bool snapshotList_isAtEnd(snapshot_list_view_t* view);
+
+/** @brief Get currently selected snapshot elements data
+ *
+ * @param[in]    view   snapshot context
+ * @param[out]   data   pointer to a pointer which will be set to data of currently selected element
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t snapshotList_getCurrentData(snapshot_list_view_t* view, void** data);
+
+#endif /* SRC_TOOLS_SNAPSHOT_LIST_H_ */
@@ -0,0 +1,290 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file sorted_list.c
+ * @brief Sorted mode for generic list
+ *
+ * Skip index is a set of towers pointing at list nodes. Every node is a member
+ * of the base (generic) list, about one in four nodes has a tower, one in
+ * sixteen reaches second index level and so on. Searches descend the towers
+ * and finish with a short walk over the base list.
+ *
+ */
+
+#include "sorted_list.h"
+
+/** Initial state of index level generator, any non zero value */
+#define SORTED_LIST_SEED    (0x9E3779B9u)
+
+/* Tower following pred at given level, NULL pred stands for index head */
+static sorted_list_tower_t* successor(sorted_list_t* list, sorted_list_tower_t* pred, unsigned int level)
+{
+    return ( NULL == pred ) ? list->index[level] : pred->forward[level];
+}
+
+static void setSuccessor(sorted_list_t* list, sorted_list_tower_t* pred, unsigned int level, sorted_list_tower_t* tower)
+{
+    if ( NULL == pred )
+    {
+        list->index[level] = tower;
+    }
+    else
+    {
+        pred->forward[level] = tower;
+    }
+}
+
+/* Draw tower height, 0 means node is not indexed. P(height >= h) = 4^-h */
+static unsigned int randomHeight(sorted_list_t* list)
+{
+    unsigned int height = 0;
+    uint32_t r = list->seed;
+
+    /* xorshift32 */
+    r ^= r << 13;
+    r ^= r >> 17;
+    r ^= r << 5;
+    list->seed = r;
+
+    while ( ( 0 == ( r & 3u ) ) && ( height < SORTED_LIST_MAX_LEVEL ) )
+    {
+        height++;
+        r >>= 2;
+    }
+    return height;
+}
+
+/* Does node belong before the searched position */
+static bool precedes(sorted_list_t* list, const void* data, const void* key, bool inclusive)
+{
+    int cmp = list->compareFunc(data, key);
+    return inclusive ? ( cmp <= 0 ) : ( cmp < 0 );
+}
+
+/* Find first node not preceding key, fill update with last tower preceding key on every level */
+static generic_list_node_t* search(sorted_list_t* list, const void* key, bool inclusive, sorted_list_tower_t** update)
+{
+    sorted_list_tower_t* pred = NULL;
+    generic_list_node_t* node;
+
+    for ( unsigned int l = SORTED_LIST_MAX_LEVEL; l-- > 0; )
+    {
+        if ( l < list->level )
+        {
+            sorted_list_tower_t* next = successor(list, pred, l);
+            while ( ( NULL != next ) && precedes(list, next->node->data, key, inclusive) )
+            {
+                pred = next;
+                next = successor(list, pred, l);
+            }
+        }
+        if ( NULL != update )
+        {
+            update[l] = pred;
+        }
+    }
+
+    /* Finish in base list */
+    node = ( NULL == pred ) ? list->list.head : pred->node->next;
+    while ( ( NULL != node ) && precedes(list, node->data, key, inclusive) )
+    {
+        node = node->next;
+    }
+    return node;
+}
+
+list_error_t sortedList_newList(sorted_list_t* list, compareData compareFunc, freeData freeFunc, allocData allocFunc)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == compareFunc, LIST_INVALID_PARAM );
+
+    for ( unsigned int l = 0; l < SORTED_LIST_MAX_LEVEL; l++ )
+    {
+        list->index[l] = NULL;
+    }
+    list->level = 0;
+    list->seed = SORTED_LIST_SEED;
+    list->compareFunc = compareFunc;
+
+    return genericList_newList(&list->list, freeFunc, allocFunc);
+}
+
+list_error_t sortedList_insertSorted(sorted_list_t* list, void* data)
+{
+    sorted_list_tower_t* update[SORTED_LIST_MAX_LEVEL];
+    sorted_list_tower_t* tower;
+    generic_list_node_t* next;
+    generic_list_node_t* newNode;
+    unsigned int height;
+    list_error_t err;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+
+    /* Place after all equal elements to keep duplicates stable */
+    next = search(list, data, true, update);
+    err = genericList_insertBefore(&list->list, next, data);
+    if ( LIST_SUCCESS != err )
+    {
+        return err;
+    }
+    newNode = ( NULL == next ) ? list->list.tail : next->prev;
+
+    height = randomHeight(list);
+    if ( 0 == height )
+    {
+        return LIST_SUCCESS;
+    }
+    tower = (sorted_list_tower_t*)list->list.allocFunc(sizeof(sorted_list_tower_t) + height * sizeof(sorted_list_tower_t*));
+    if ( NULL == tower )
+    {
+        /* Element stays in the list, just not indexed */
+        return LIST_SUCCESS;
+    }
+    tower->node = newNode;
+    tower->height = height;
+    for ( unsigned int l = 0; l < height; l++ )
+    {
+        tower->forward[l] = successor(list, update[l], l);
+        setSuccessor(list, update[l], l, tower);
+    }
+    if ( height > list->level )
+    {
+        list->level = height;
+    }
+    return LIST_SUCCESS;
+}
+
+list_error_t sortedList_lowerBound(sorted_list_t* list, const void* key, generic_list_node_t** node)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == node, LIST_INVALID_PARAM );
+
+    *node = search(list, key, false, NULL);
+    return ( NULL != *node ) ? LIST_SUCCESS : LIST_NOT_FOUND;
+}
+
+list_error_t sortedList_upperBound(sorted_list_t* list, const void* key, generic_list_node_t** node)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == node, LIST_INVALID_PARAM );
+
+    *node = search(list, key, true, NULL);
+    return ( NULL != *node ) ? LIST_SUCCESS : LIST_NOT_FOUND;
+}
+
+list_error_t sortedList_range(sorted_list_t* list, const void* lowKey, const void* highKey, sorted_list_range_t* range)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == range, LIST_INVALID_PARAM );
+
+    range->end = search(list, highKey, true, NULL);
+    if ( list->compareFunc(lowKey, highKey) > 0 )
+    {
+        /* Empty range */
+        range->current = range->end;
+    }
+    else
+    {
+        range->current = search(list, lowKey, false, NULL);
+    }
+    return LIST_SUCCESS;
+}
+
+list_error_t sortedList_rangeNext(sorted_list_range_t* range, void** data)
+{
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( ( NULL == range ) || ( NULL == data ), LIST_INVALID_PARAM );
+
+    if ( range->current == range->end )
+    {
+        return LIST_NOT_FOUND;
+    }
+    *data = range->current->data;
+    range->current = range->current->next;
+    return LIST_SUCCESS;
+}
+
+list_error_t sortedList_removeElement(sorted_list_t* list, generic_list_node_t* node)
+{
+    sorted_list_tower_t* update[SORTED_LIST_MAX_LEVEL];
+    sorted_list_tower_t* tower = NULL;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+    GENERIC_LIST_VALIDATE( NULL == node, LIST_INVALID_PARAM );
+
+    /* Last towers lower than node, its own tower (if any) is among following equal ones */
+    (void)search(list, node->data, false, update);
+    for ( unsigned int l = 0; l < list->level; l++ )
+    {
+        sorted_list_tower_t* pred = update[l];
+        sorted_list_tower_t* next = successor(list, pred, l);
+        while ( ( NULL != next ) && ( next->node != node ) && ( 0 == list->compareFunc(next->node->data, node->data) ) )
+        {
+            pred = next;
+            next = successor(list, pred, l);
+        }
+        if ( ( NULL == next ) || ( next->node != node ) )
+        {
+            /* Tower does not reach this level */
+            break;
+        }
+        tower = next;
+        setSuccessor(list, pred, l, tower->forward[l]);
+    }
+    if ( NULL != tower )
+    {
+        list->list.freeFunc(tower);
+        while ( ( list->level > 0 ) && ( NULL == list->index[list->level - 1] ) )
+        {
+            list->level--;
+        }
+    }
+
+    return genericList_removeElement(&list->list, node);
+}
+
+list_error_t sortedList_freeList(sorted_list_t* list)
+{
+    sorted_list_tower_t* tower;
+    /* Validate params */
+    GENERIC_LIST_VALIDATE( NULL == list, LIST_INVALID_PARAM );
+
+    /* Every tower is linked on the lowest index level */
+    tower = list->index[0];
+    while ( NULL != tower )
+    {
+        sorted_list_tower_t* next = tower->forward[0];
+        list->list.freeFunc(tower);
+        tower = next;
+    }
+    for ( unsigned int l = 0; l < SORTED_LIST_MAX_LEVEL; l++ )
+    {
+        list->index[l] = NULL;
+    }
+    list->level = 0;
+
+    return genericList_freeList(&list->list);
+}
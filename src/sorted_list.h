@@ -0,0 +1,162 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file sorted_list.h
+ * @brief Sorted mode for generic list
+ *
+ * Keeps a @ref generic_list_t ordered by a user comparator. A probabilistic
+ * skip index is kept over the list nodes so that ordered insertion and bound
+ * lookups take O(log n) expected comparisons instead of a linear scan.
+ *
+ * The underlying list can be iterated with the regular genericList_rewind,
+ * genericList_next, ... functions, but must only be modified with the
+ * sortedList_* functions, otherwise the index gets out of sync.
+ *
+ */
+
+#ifndef SRC_TOOLS_SORTED_LIST_H_
+#define SRC_TOOLS_SORTED_LIST_H_
+
+#include "generic_list.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum height of the skip index, enough for 4^16 elements */
+#define SORTED_LIST_MAX_LEVEL   (16)
+
+/** Comparator, returns negative, zero or positive value if first argument is
+ *  respectively lower than, equal to or greater than the second one */
+typedef int (*compareData)(const void*, const void*);
+
+typedef struct sorted_list_tower_t
+{
+    generic_list_node_t* node;
+    unsigned int height;
+    struct sorted_list_tower_t* forward[];
+}sorted_list_tower_t;
+
+typedef struct
+{
+    generic_list_t list;
+    compareData compareFunc;
+    sorted_list_tower_t* index[SORTED_LIST_MAX_LEVEL];
+    unsigned int level;
+    uint32_t seed;
+}sorted_list_t;
+
+typedef struct
+{
+    generic_list_node_t* current;
+    generic_list_node_t* end;
+}sorted_list_range_t;
+
+/** @brief Create new sorted list
+ *
+ * @param[in]   list          pointer to sorted list context structure
+ * @param[in]   compareFunc   comparator defining list order @ref compareData
+ * @param[in]   freeFunc      pointer to function used to free memory @ref freeData
+ * @param[in]   allocFunc     pointer to function used to allocate memory @ref allocData
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t sortedList_newList(sorted_list_t* list, compareData compareFunc, freeData freeFunc, allocData allocFunc);
+
+/** @brief Insert element keeping list order
+ *         Elements equal to already stored ones are placed after them,
+ *         so insertion order of duplicates is preserved
+ *
+ * @param[in]   list   pointer to sorted list context structure
+ * @param[in]   data   pointer to data that will be stored in the list
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t sortedList_insertSorted(sorted_list_t* list, void* data);
+
+/** @brief Find first element which is not lower than key
+ *
+ * @param[in]    list   pointer to sorted list context structure
+ * @param[in]    key    data compared against elements with list comparator
+ * @param[out]   node   set to found node or NULL if there is none
+ *
+ * @return LIST_SUCCESS on success, LIST_NOT_FOUND if all elements are lower than key,
+ *         error code otherwise. @ref list_error_t
+ */
+list_error_t sortedList_lowerBound(sorted_list_t* list, const void* key, generic_list_node_t** node);
+
+/** @brief Find first element which is greater than key
+ *
+ * @param[in]    list   pointer to sorted list context structure
+ * @param[in]    key    data compared against elements with list comparator
+ * @param[out]   node   set to found node or NULL if there is none
+ *
+ * @return LIST_SUCCESS on success, LIST_NOT_FOUND if no element is greater than key,
+ *         error code otherwise. @ref list_error_t
+ */
+list_error_t sortedList_upperBound(sorted_list_t* list, const void* key, generic_list_node_t** node);
+
+/** @brief Prepare iteration over elements in range [lowKey, highKey]
+ *
+ * @param[in]    list      pointer to sorted list context structure
+ * @param[in]    lowKey    lower inclusive range limit
+ * @param[in]    highKey   upper inclusive range limit
+ * @param[out]   range     range iterator context
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t sortedList_range(sorted_list_t* list, const void* lowKey, const void* highKey, sorted_list_range_t* range);
+
+/** @brief Get data of next element in range
+ *
+ * @param[in]    range   range iterator context
+ * @param[out]   data    pointer to a pointer which will be set to data of next element
+ *
+ * @return LIST_SUCCESS on success, LIST_NOT_FOUND when range is exhausted,
+ *         error code otherwise. @ref list_error_t
+ */
+list_error_t sortedList_rangeNext(sorted_list_range_t* range, void** data);
+
+/** @brief Remove given node from sorted list
+ *         NOTE: Data stored in the node will also be freed!
+ *
+ * @param[in]   list   pointer to sorted list context structure
+ * @param[in]   node   node belonging to the list
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t sortedList_removeElement(sorted_list_t* list, generic_list_node_t* node);
+
+/** @brief Free sorted list, its index and its elements
+ *         NOTE: Data stored in the list will also be freed!
+ *
+ * @param[in]   list   pointer to sorted list context structure
+ *
+ * @return LIST_SUCCESS on success, error code otherwise. @ref list_error_t
+ */
+list_error_t sortedList_freeList(sorted_list_t* list);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SRC_TOOLS_SORTED_LIST_H_ */
@@ -31,58 +31,48 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
 #include <check.h>
 #include "generic_list.h"
+#include "sorted_list.h"
+#include "snapshot_list.h"
+#include "node_cache.h"
+#include "node_arena.h"
+#include "keyed_list.h"
+#include "mem_trace.h"
+#include "concurrent_list.h"
+#include "list_view.h"
+#include "list_metrics.h"
 
 #define MAX_ALLOCATED_BLOCKS     (256)
 
-typedef struct
-{
-    void* ptr;
-    size_t allocatedSize;
-}memory_block_t;
-
-static memory_block_t memoryTrace[MAX_ALLOCATED_BLOCKS];
-
 static volatile uint32_t allocatedMem = 0;
 
 void* tracedMalloc(size_t requestedSize)
 {
-    void* res = NULL;
-
-    /* Find space in memory trace */
-    for ( uint32_t i = 0; i < MAX_ALLOCATED_BLOCKS; i++ )
-    {
-        if ( 0 == memoryTrace[i].allocatedSize )
-        {
-            /* Got place in memory trace */
-            res = malloc(requestedSize);
-            if ( NULL != res )
-            {
-                memoryTrace[i].ptr = res;
-                memoryTrace[i].allocatedSize = requestedSize;
-                allocatedMem += requestedSize;
-            }
-            break;
-        }
-    }
+    mem_trace_stats_t stats;
+    void* res = memTrace_malloc(requestedSize);
+    memTrace_getStats(&stats);
+    allocatedMem = (uint32_t)stats.liveBytes;
     return res;
 }
 
 void tracedFree(void* ptr)
 {
-    /* Find address in memory trace */
-    for ( uint32_t i = 0; i < MAX_ALLOCATED_BLOCKS; i++ )
-    {
-        if ( ptr == memoryTrace[i].ptr)
-        {
-            /* Got trace */
-            memoryTrace[i].ptr = NULL;
-            allocatedMem -= memoryTrace[i].allocatedSize;
-            memoryTrace[i].allocatedSize = 0;
-            free(ptr);
-        }
-    }
+    mem_trace_stats_t stats;
+    memTrace_free(ptr);
+    memTrace_getStats(&stats);
+    allocatedMem = (uint32_t)stats.liveBytes;
+}
+
+static uint8_t* newByte(uint8_t value)
+{
+    uint8_t* data = (uint8_t*)tracedMalloc(sizeof(uint8_t));
+    ck_assert_ptr_ne(data, NULL);
+    *data = value;
+    return data;
 }
 
 START_TEST(generic_list_create)
@@ -212,6 +202,144 @@ START_TEST(generic_list_remove)
 }
 END_TEST
 
+START_TEST(generic_list_iterate)
+{
+    generic_list_t list;
+    list_error_t err;
+    uint32_t memStart = allocatedMem;
+    uint32_t visited = 0;
+    /* Create new list with three elements */
+    err =  genericList_newList(&list, tracedFree, tracedMalloc);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    for ( uint8_t i = 0; i < 3; i++ )
+    {
+        uint8_t* data = (uint8_t*)tracedMalloc(sizeof(uint8_t));
+        ck_assert_ptr_ne(data, NULL);
+        *data = i;
+        err = genericList_append(&list, data);
+        ck_assert_int_eq(err, LIST_SUCCESS);
+    }
+
+    err = genericList_rewind(&list);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    while ( !genericList_isAtEnd(&list) )
+    {
+        void* data;
+        err = genericList_getCurrentData(&list, &data);
+        ck_assert_int_eq(err, LIST_SUCCESS);
+        ck_assert_int_eq(*(uint8_t*)data, visited);
+        ck_assert_int_eq(genericList_isAtLastElement(&list), (visited == 2));
+        visited++;
+        err = genericList_next(&list);
+        ck_assert_int_eq(err, LIST_SUCCESS);
+    }
+    ck_assert_int_eq(visited, 3);
+
+    /* Stepping past the end is reported */
+    err = genericList_next(&list);
+    ck_assert_int_eq(err, LIST_NOT_FOUND);
+
+    err = genericList_freeList(&list);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+
+    ck_assert_int_eq(memStart, allocatedMem);
+}
+END_TEST
+
+#if !defined(GENERIC_LIST_UNCHECKED)
+#define WRAP_TEST_ELEMENTS      (5u)
+
+START_TEST(generic_list_invalid_params)
+{
+    generic_list_t list;
+    list_error_t err;
+    void* data;
+    generic_list_node_t* node;
+
+    err =  genericList_newList(NULL, tracedFree, tracedMalloc);
+    ck_assert_int_eq(err, LIST_INVALID_PARAM);
+    err =  genericList_newList(&list, tracedFree, tracedMalloc);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+
+    ck_assert_int_eq(genericList_append(NULL, NULL), LIST_INVALID_PARAM);
+    ck_assert_int_eq(genericList_insert(&list, NULL, 1), LIST_INVALID_PARAM);
+    ck_assert_int_eq(genericList_getElementAt(&list, 0, &node), LIST_INVALID_PARAM);
+    ck_assert_int_eq(genericList_getDataAt(&list, 0, NULL), LIST_INVALID_PARAM);
+    ck_assert_int_eq(genericList_removeElementAt(&list, 0), LIST_INVALID_PARAM);
+    ck_assert_int_eq(genericList_rewind(NULL), LIST_INVALID_PARAM);
+    ck_assert_int_eq(genericList_next(&list), LIST_INVALID_PARAM);
+    ck_assert_int_eq(genericList_isAtEnd(NULL), false);
+    ck_assert_int_eq(genericList_getCurrentElement(&list, NULL), LIST_INVALID_PARAM);
+    ck_assert_int_eq(genericList_getCurrentData(NULL, &data), LIST_INVALID_PARAM);
+
+    /* 64-bit indices past UINT_MAX must not wrap, truncated ones hit head and tail walks */
+    for ( uint8_t i = 0; i < WRAP_TEST_ELEMENTS; i++ )
+    {
+        ck_assert_int_eq(genericList_append(&list, newByte(i)), LIST_SUCCESS);
+    }
+    for ( size_t i = 0; i < WRAP_TEST_ELEMENTS; i++ )
+    {
+        size_t index = (size_t)UINT32_MAX + 1u + i;
+        ck_assert_int_eq(genericList_getElementAt64(&list, index, &node), LIST_INVALID_PARAM);
+        ck_assert_int_eq(genericList_getDataAt64(&list, index, &data), LIST_INVALID_PARAM);
+        ck_assert_int_eq(genericList_insert64(&list, NULL, index), LIST_INVALID_PARAM);
+        ck_assert_int_eq(genericList_removeElementAt64(&list, index), LIST_INVALID_PARAM);
+    }
+    ck_assert_int_eq(genericList_getDataAt64(&list, SIZE_MAX, &data), LIST_INVALID_PARAM);
+    ck_assert_int_eq(genericList_removeElementAt64(&list, SIZE_MAX), LIST_INVALID_PARAM);
+    ck_assert_uint_eq(list.size, WRAP_TEST_ELEMENTS);
+    for ( size_t i = 0; i < WRAP_TEST_ELEMENTS; i++ )
+    {
+        ck_assert_int_eq(genericList_getDataAt64(&list, i, &data), LIST_SUCCESS);
+        ck_assert_uint_eq(*(uint8_t*)data, i);
+    }
+    ck_assert_int_eq(genericList_freeList(&list), LIST_SUCCESS);
+}
+END_TEST
+#endif
+
+#define INDEX64_TEST_ELEMENTS    (9u)
+
+START_TEST(generic_list_index64)
+{
+    generic_list_t list;
+    generic_list_node_t* node;
+    void* data;
+    size_t i = 0;
+
+    ck_assert_int_eq(genericList_newList(&list, tracedFree, tracedMalloc), LIST_SUCCESS);
+    for ( uint8_t value = 0; value < INDEX64_TEST_ELEMENTS; value++ )
+    {
+        ck_assert_int_eq(genericList_insert64(&list, newByte(value), list.size), LIST_SUCCESS);
+    }
+
+    /* Both halves, reached from head and from tail, match iteration order */
+    genericList_rewind(&list);
+    while ( !genericList_isAtEnd(&list) )
+    {
+        ck_assert_int_eq(genericList_getElementAt64(&list, i, &node), LIST_SUCCESS);
+        ck_assert_ptr_eq(node, list.current);
+        ck_assert_int_eq(genericList_getDataAt64(&list, i, &data), LIST_SUCCESS);
+        ck_assert_uint_eq(*(uint8_t*)data, i);
+        genericList_next(&list);
+        i++;
+    }
+
+    /* Insert and remove near the tail */
+    ck_assert_int_eq(genericList_insert64(&list, newByte(100), INDEX64_TEST_ELEMENTS - 1), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_getDataAt64(&list, INDEX64_TEST_ELEMENTS - 1, &data), LIST_SUCCESS);
+    ck_assert_uint_eq(*(uint8_t*)data, 100);
+    ck_assert_int_eq(genericList_getDataAt64(&list, INDEX64_TEST_ELEMENTS, &data), LIST_SUCCESS);
+    ck_assert_uint_eq(*(uint8_t*)data, INDEX64_TEST_ELEMENTS - 1);
+    ck_assert_int_eq(genericList_removeElementAt64(&list, INDEX64_TEST_ELEMENTS - 1), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_getDataAt64(&list, INDEX64_TEST_ELEMENTS - 2, &data), LIST_SUCCESS);
+    ck_assert_uint_eq(*(uint8_t*)data, INDEX64_TEST_ELEMENTS - 2);
+    ck_assert_uint_eq(list.size, INDEX64_TEST_ELEMENTS);
+
+    ck_assert_int_eq(genericList_freeList(&list), LIST_SUCCESS);
+    ck_assert_uint_eq(allocatedMem, 0);
+}
+END_TEST
 
 Suite * generic_list_suite(void)
 {
@@ -227,109 +355,1748 @@ Suite * generic_list_suite(void)
     tcase_add_test(tc_core, generic_list_append_and_free);
     tcase_add_test(tc_core, generic_list_insert);
     tcase_add_test(tc_core, generic_list_remove);
+    tcase_add_test(tc_core, generic_list_iterate);
+    tcase_add_test(tc_core, generic_list_index64);
+#if !defined(GENERIC_LIST_UNCHECKED)
+    tcase_add_test(tc_core, generic_list_invalid_params);
+#endif
 
     suite_add_tcase(s, tc_core);
 
     return s;
 }
 
-START_TEST(tools_malloc_free_manual8)
+typedef struct
 {
-    uint32_t startMem = allocatedMem;
-    size_t mallocSize = 128;
-    void* ptr1 = tracedMalloc(mallocSize);
+    int key;
+    int seq;
+}sorted_item_t;
 
-    ck_assert_int_eq(startMem, allocatedMem - mallocSize);
+static int compareItems(const void* a, const void* b)
+{
+    int keyA = ((const sorted_item_t*)a)->key;
+    int keyB = ((const sorted_item_t*)b)->key;
+    return ( keyA > keyB ) - ( keyA < keyB );
+}
 
-    void* ptr2 = tracedMalloc(mallocSize);
-    void* ptr3 = tracedMalloc(mallocSize);
-    void* ptr4 = tracedMalloc(mallocSize);
-    void* ptr5 = tracedMalloc(mallocSize);
-    void* ptr6 = tracedMalloc(mallocSize);
-    void* ptr7 = tracedMalloc(mallocSize);
-    void* ptr8 = tracedMalloc(mallocSize);
+static sorted_item_t* newItem(int key, int seq)
+{
+    sorted_item_t* item = (sorted_item_t*)tracedMalloc(sizeof(sorted_item_t));
+    ck_assert_ptr_ne(item, NULL);
+    item->key = key;
+    item->seq = seq;
+    return item;
+}
 
-    ck_assert_int_eq(startMem, allocatedMem - (8 * mallocSize) );
+#define SORTED_TEST_ELEMENTS    (60)
 
-    tracedFree(ptr1);
-    tracedFree(ptr2);
-    tracedFree(ptr3);
-    tracedFree(ptr4);
-    tracedFree(ptr5);
-    tracedFree(ptr6);
-    tracedFree(ptr7);
-    tracedFree(ptr8);
+START_TEST(sorted_list_insert_order)
+{
+    sorted_list_t list;
+    list_error_t err;
+    uint32_t memStart = allocatedMem;
+    sorted_item_t* prev = NULL;
+    size_t count = 0;
 
-    ck_assert_int_eq(startMem, allocatedMem);
+    err = sortedList_newList(&list, compareItems, tracedFree, tracedMalloc);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    /* Keys repeat every 20 elements, so every key has three duplicates */
+    for ( int i = 0; i < SORTED_TEST_ELEMENTS; i++ )
+    {
+        err = sortedList_insertSorted(&list, newItem( ( i * 7 ) % 20, i ));
+        ck_assert_int_eq(err, LIST_SUCCESS);
+    }
+    ck_assert_int_eq(list.list.size, SORTED_TEST_ELEMENTS);
 
+    /* Ordered by key, duplicates in insertion order */
+    genericList_rewind(&list.list);
+    while ( !genericList_isAtEnd(&list.list) )
+    {
+        void* data;
+        sorted_item_t* item;
+        genericList_getCurrentData(&list.list, &data);
+        item = (sorted_item_t*)data;
+        if ( NULL != prev )
+        {
+            ck_assert_int_le(prev->key, item->key);
+            if ( prev->key == item->key )
+            {
+                ck_assert_int_lt(prev->seq, item->seq);
+            }
+        }
+        prev = item;
+        count++;
+        genericList_next(&list.list);
+    }
+    ck_assert_int_eq(count, SORTED_TEST_ELEMENTS);
+
+    err = sortedList_freeList(&list);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    ck_assert_int_eq(memStart, allocatedMem);
 }
+END_TEST
 
-START_TEST(tools_malloc_free_loop_all)
+START_TEST(sorted_list_bounds_and_range)
 {
+    sorted_list_t list;
+    sorted_list_range_t range;
+    generic_list_node_t* node;
+    list_error_t err;
     uint32_t memStart = allocatedMem;
-    size_t mallocSize = 16;
-    void** memtable;
-    memtable = (void**)malloc(sizeof(void*)*MAX_ALLOCATED_BLOCKS);
+    sorted_item_t key = { 0, 0 };
+    sorted_item_t highKey = { 0, 0 };
+    void* data;
+    int seen = 0;
 
-    for ( uint32_t i = 0; i < MAX_ALLOCATED_BLOCKS; i++)
+    err = sortedList_newList(&list, compareItems, tracedFree, tracedMalloc);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    /* Even keys 0..58, key 10 stored twice */
+    for ( int i = 0; i < SORTED_TEST_ELEMENTS; i += 2 )
     {
-        memtable[i] = tracedMalloc(mallocSize);
+        err = sortedList_insertSorted(&list, newItem(i, i));
+        ck_assert_int_eq(err, LIST_SUCCESS);
     }
+    err = sortedList_insertSorted(&list, newItem(10, 100));
+    ck_assert_int_eq(err, LIST_SUCCESS);
 
-    ck_assert_int_eq(memStart, allocatedMem - MAX_ALLOCATED_BLOCKS * mallocSize);
+    key.key = 10;
+    err = sortedList_lowerBound(&list, &key, &node);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    ck_assert_int_eq(((sorted_item_t*)node->data)->key, 10);
+    ck_assert_int_eq(((sorted_item_t*)node->data)->seq, 10);
+    err = sortedList_upperBound(&list, &key, &node);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    ck_assert_int_eq(((sorted_item_t*)node->data)->key, 12);
 
-    for ( uint32_t i = 0; i < MAX_ALLOCATED_BLOCKS; i++)
+    key.key = 11;
+    err = sortedList_lowerBound(&list, &key, &node);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    ck_assert_int_eq(((sorted_item_t*)node->data)->key, 12);
+
+    key.key = 58;
+    err = sortedList_upperBound(&list, &key, &node);
+    ck_assert_int_eq(err, LIST_NOT_FOUND);
+    ck_assert_ptr_eq(node, NULL);
+
+    /* [9, 14] contains 10, 10, 12, 14 */
+    key.key = 9;
+    highKey.key = 14;
+    err = sortedList_range(&list, &key, &highKey, &range);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    while ( LIST_SUCCESS == sortedList_rangeNext(&range, &data) )
     {
-        tracedFree(memtable[i]);
+        ck_assert_int_ge(((sorted_item_t*)data)->key, 9);
+        ck_assert_int_le(((sorted_item_t*)data)->key, 14);
+        seen++;
+    }
+    ck_assert_int_eq(seen, 4);
+
+    /* Inverted range is empty */
+    err = sortedList_range(&list, &highKey, &key, &range);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    ck_assert_int_eq(sortedList_rangeNext(&range, &data), LIST_NOT_FOUND);
+
+    /* Remove every element through its node, index must stay consistent */
+    while ( NULL != list.list.head )
+    {
+        key.key = ((sorted_item_t*)list.list.tail->data)->key;
+        err = sortedList_removeElement(&list, list.list.tail);
+        ck_assert_int_eq(err, LIST_SUCCESS);
+        if ( NULL != list.list.head )
+        {
+            err = sortedList_upperBound(&list, &key, &node);
+            ck_assert_int_eq(err, LIST_NOT_FOUND);
+        }
     }
+    ck_assert_int_eq(list.list.size, 0);
+    ck_assert_int_eq(list.level, 0);
 
+    err = sortedList_freeList(&list);
+    ck_assert_int_eq(err, LIST_SUCCESS);
     ck_assert_int_eq(memStart, allocatedMem);
-    free(memtable);
+}
+END_TEST
+
+Suite * sorted_list_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("sorted-list");
+
+    /* Core test case */
+    tc_core = tcase_create("Core");
+
+    tcase_add_test(tc_core, sorted_list_insert_order);
+    tcase_add_test(tc_core, sorted_list_bounds_and_range);
 
+    suite_add_tcase(s, tc_core);
+
+    return s;
 }
 
-Suite * tools_suite(void)
+/* Check that snapshot contains exactly expected values */
+static void checkSnapshot(snapshot_list_view_t* view, const uint8_t* expected, size_t count)
+{
+    size_t i = 0;
+    ck_assert_int_eq(snapshotList_rewind(view), LIST_SUCCESS);
+    while ( !snapshotList_isAtEnd(view) )
+    {
+        void* data;
+        ck_assert_int_eq(snapshotList_getCurrentData(view, &data), LIST_SUCCESS);
+        ck_assert_uint_lt(i, count);
+        ck_assert_int_eq(*(uint8_t*)data, expected[i]);
+        i++;
+        ck_assert_int_eq(snapshotList_next(view), LIST_SUCCESS);
+    }
+    ck_assert_uint_eq(i, count);
+}
+
+START_TEST(snapshot_list_isolation)
+{
+    snapshot_list_t list;
+    snapshot_list_view_t first;
+    snapshot_list_view_t second;
+    list_error_t err;
+    uint32_t memStart = allocatedMem;
+    const uint8_t firstExpected[] = { 1, 2, 3 };
+    const uint8_t secondExpected[] = { 1, 3, 4 };
+    const uint8_t currentExpected[] = { 3, 4 };
+    uint32_t memBeforeRelease;
+
+    err = snapshotList_newList(&list, tracedFree, tracedMalloc);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    for ( uint8_t i = 1; i <= 3; i++ )
+    {
+        err = snapshotList_append(&list, newByte(i));
+        ck_assert_int_eq(err, LIST_SUCCESS);
+    }
+
+    err = snapshotList_snapshot(&list, &first);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    err = snapshotList_removeElementAt(&list, 1);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    err = snapshotList_append(&list, newByte(4));
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    err = snapshotList_snapshot(&list, &second);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    err = snapshotList_removeElementAt(&list, 0);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    ck_assert_uint_eq(list.size, 2);
+
+    /* Snapshots are frozen, removed elements are kept alive for them */
+    checkSnapshot(&first, firstExpected, 3);
+    checkSnapshot(&second, secondExpected, 3);
+    ck_assert_int_eq(snapshotList_freeList(&list), LIST_INVALID_PARAM);
+
+    /* Releasing the first snapshot unlinks element 2, second one may still be walking over it */
+    memBeforeRelease = allocatedMem;
+    ck_assert_int_eq(snapshotList_release(&first), LIST_SUCCESS);
+    ck_assert_int_eq(snapshotList_reclaim(&list), LIST_SUCCESS);
+    ck_assert_uint_eq(list.deadLinked, 1);
+    ck_assert_uint_eq(allocatedMem, memBeforeRelease);
+    checkSnapshot(&second, secondExpected, 3);
+
+    /* Both removed elements are freed with the last snapshot */
+    ck_assert_int_eq(snapshotList_release(&second), LIST_SUCCESS);
+    ck_assert_int_eq(snapshotList_reclaim(&list), LIST_SUCCESS);
+    ck_assert_uint_eq(list.deadLinked, 0);
+    ck_assert_ptr_eq(list.retired, NULL);
+    ck_assert_uint_eq(allocatedMem, memBeforeRelease - 2 * ( sizeof(uint8_t) + sizeof(snapshot_list_node_t) ));
+    ck_assert_int_eq(snapshotList_snapshot(&list, &first), LIST_SUCCESS);
+    checkSnapshot(&first, currentExpected, 2);
+    ck_assert_int_eq(snapshotList_release(&first), LIST_SUCCESS);
+
+    err = snapshotList_freeList(&list);
+    ck_assert_int_eq(err, LIST_SUCCESS);
+    ck_assert_int_eq(memStart, allocatedMem);
+}
+END_TEST
+
+#define SNAPSHOT_WRITES         (20000u)
+#define SNAPSHOT_WINDOW         (64u)
+#define SNAPSHOT_READERS        (3)
+
+static _Atomic(bool) snapshotWriterDone;
+
+static void* snapshotWriter(void* arg)
+{
+    snapshot_list_t* list = (snapshot_list_t*)arg;
+    for ( uint32_t i = 0; i < SNAPSHOT_WRITES; i++ )
+    {
+        uint32_t* value = (uint32_t*)malloc(sizeof(uint32_t));
+        *value = i;
+        if ( LIST_SUCCESS != snapshotList_append(list, value) )
+        {
+            break;
+        }
+        if ( list->size > SNAPSHOT_WINDOW )
+        {
+            (void)snapshotList_removeElementAt(list, 0);
+        }
+    }
+    atomic_store(&snapshotWriterDone, true);
+    return NULL;
+}
+
+/* Every snapshot must contain a gap free run of values */
+static void* snapshotReader(void* arg)
+{
+    snapshot_list_t* list = (snapshot_list_t*)arg;
+    uintptr_t failures = 0;
+    while ( !atomic_load(&snapshotWriterDone) )
+    {
+        snapshot_list_view_t view;
+        uint32_t prev = UINT32_MAX;
+        if ( LIST_SUCCESS != snapshotList_snapshot(list, &view) )
+        {
+            continue;
+        }
+        while ( !snapshotList_isAtEnd(&view) )
+        {
+            void* data;
+            (void)snapshotList_getCurrentData(&view, &data);
+            if ( ( UINT32_MAX != prev ) && ( *(uint32_t*)data != prev + 1 ) )
+            {
+                failures++;
+            }
+            prev = *(uint32_t*)data;
+            (void)snapshotList_next(&view);
+        }
+        (void)snapshotList_release(&view);
+    }
+    return (void*)failures;
+}
+
+START_TEST(snapshot_list_concurrent)
+{
+    snapshot_list_t list;
+    pthread_t writer;
+    pthread_t readers[SNAPSHOT_READERS];
+
+    ck_assert_int_eq(snapshotList_newList(&list, free, malloc), LIST_SUCCESS);
+    atomic_store(&snapshotWriterDone, false);
+    for ( int i = 0; i < SNAPSHOT_READERS; i++ )
+    {
+        ck_assert_int_eq(pthread_create(&readers[i], NULL, snapshotReader, &list), 0);
+    }
+    ck_assert_int_eq(pthread_create(&writer, NULL, snapshotWriter, &list), 0);
+
+    pthread_join(writer, NULL);
+    for ( int i = 0; i < SNAPSHOT_READERS; i++ )
+    {
+        void* failures;
+        pthread_join(readers[i], &failures);
+        ck_assert_ptr_eq(failures, NULL);
+    }
+    ck_assert_uint_eq(list.size, SNAPSHOT_WINDOW);
+
+    /* Without snapshots everything removed is reclaimed */
+    ck_assert_int_eq(snapshotList_reclaim(&list), LIST_SUCCESS);
+    ck_assert_uint_eq(list.deadLinked, 0);
+    ck_assert_ptr_eq(list.retired, NULL);
+    ck_assert_int_eq(snapshotList_freeList(&list), LIST_SUCCESS);
+}
+END_TEST
+
+Suite * snapshot_list_suite(void)
 {
     Suite *s;
     TCase *tc_core;
 
-    s = suite_create("tools-test");
+    s = suite_create("snapshot-list");
 
     /* Core test case */
-    tc_core = tcase_create("Tools");
+    tc_core = tcase_create("Core");
 
-    tcase_add_test(tc_core, tools_malloc_free_manual8);
-    tcase_add_test(tc_core, tools_malloc_free_loop_all);
+    tcase_add_test(tc_core, snapshot_list_isolation);
+    tcase_add_test(tc_core, snapshot_list_concurrent);
 
     suite_add_tcase(s, tc_core);
 
     return s;
 }
 
-int main(void)
+#define NODE_CACHE_TEST_ELEMENTS    (100u)
+
+static void fillList(generic_list_t* list, uint32_t elements)
 {
-    int number_failed = 0;
-    Suite *listSuite;
-    Suite *toolsSuite;
-    SRunner *toolsSr;
-    SRunner *sr;
+    for ( uint32_t i = 0; i < elements; i++ )
+    {
+        ck_assert_int_eq(genericList_append(list, newByte((uint8_t)i)), LIST_SUCCESS);
+    }
+}
 
-    memset(memoryTrace, 0, sizeof(memoryTrace));
+START_TEST(node_cache_reuse)
+{
+    generic_list_t list;
+    node_cache_stats_t before;
+    node_cache_stats_t after;
+    uint32_t memStart = allocatedMem;
 
-    listSuite = generic_list_suite();
-    toolsSuite = tools_suite();
+    ck_assert_int_eq(genericList_newList(&list, tracedFree, tracedMalloc), LIST_SUCCESS);
+    ck_assert_int_eq(nodeCache_attach(&list), LIST_SUCCESS);
 
-    toolsSr = srunner_create(toolsSuite);
+    /* Warm up thread cache */
+    fillList(&list, NODE_CACHE_TEST_ELEMENTS);
+    ck_assert_int_eq(genericList_freeList(&list), LIST_SUCCESS);
+    ck_assert_int_eq(memStart, allocatedMem);
 
-    sr = srunner_create(listSuite);
+    /* Second round is served from cached blocks only */
+    ck_assert_int_eq(nodeCache_getStats(&before), LIST_SUCCESS);
+    fillList(&list, NODE_CACHE_TEST_ELEMENTS);
+    ck_assert_int_eq(genericList_removeElementAt(&list, 10), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_insert(&list, newByte(10), 10), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_freeList(&list), LIST_SUCCESS);
+    ck_assert_int_eq(nodeCache_getStats(&after), LIST_SUCCESS);
+    ck_assert_uint_eq(after.systemAllocs, before.systemAllocs);
+    ck_assert_int_eq(memStart, allocatedMem);
+
+    /* Allocator can not be changed on non-empty list */
+    fillList(&list, 1);
+    ck_assert_int_eq(genericList_setNodeAllocator(&list, NULL, NULL, NULL), LIST_INVALID_PARAM);
+    ck_assert_int_eq(genericList_freeList(&list), LIST_SUCCESS);
+    ck_assert_int_eq(memStart, allocatedMem);
+}
+END_TEST
+
+static void* nodeCacheProducer(void* arg)
+{
+    generic_list_t* list = (generic_list_t*)arg;
+    for ( uint32_t i = 0; i < 10 * NODE_CACHE_MAGAZINE_SIZE; i++ )
+    {
+        if ( LIST_SUCCESS != genericList_append(list, NULL) )
+        {
+            return arg;
+        }
+    }
+    return NULL;
+}
+
+static void* nodeCacheConsumer(void* arg)
+{
+    generic_list_t* list = (generic_list_t*)arg;
+    return ( LIST_SUCCESS == genericList_freeList(list) ) ? NULL : arg;
+}
+
+START_TEST(node_cache_cross_thread)
+{
+    generic_list_t list;
+    node_cache_stats_t stats;
+    pthread_t thread;
+    void* res;
+
+    /* free(NULL) is a no-op, only nodes are allocated */
+    ck_assert_int_eq(genericList_newList(&list, free, malloc), LIST_SUCCESS);
+    ck_assert_int_eq(nodeCache_attach(&list), LIST_SUCCESS);
+
+    /* Nodes allocated by one thread are freed by another one */
+    ck_assert_int_eq(pthread_create(&thread, NULL, nodeCacheProducer, &list), 0);
+    pthread_join(thread, &res);
+    ck_assert_ptr_eq(res, NULL);
+    ck_assert_uint_eq(list.size, 10 * NODE_CACHE_MAGAZINE_SIZE);
+    ck_assert_int_eq(pthread_create(&thread, NULL, nodeCacheConsumer, &list), 0);
+    pthread_join(thread, &res);
+    ck_assert_ptr_eq(res, NULL);
+
+    /* Exited threads flushed their caches, after flushing this one nothing is held */
+    nodeCache_flushThread();
+    nodeCache_trim();
+    ck_assert_int_eq(nodeCache_getStats(&stats), LIST_SUCCESS);
+    ck_assert_uint_eq(stats.systemAllocs, stats.systemFrees);
+}
+END_TEST
+
+Suite * node_cache_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("node-cache");
+
+    /* Core test case */
+    tc_core = tcase_create("Core");
+
+    tcase_add_test(tc_core, node_cache_reuse);
+    tcase_add_test(tc_core, node_cache_cross_thread);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+#define ARENA_TEST_ELEMENTS     (1000u)
+
+static uint32_t destructorCalls;
+
+static void countingDestructor(void* data)
+{
+    (void)data;
+    destructorCalls++;
+}
+
+START_TEST(node_arena_bulk_free)
+{
+    node_arena_t arena;
+    generic_list_t list;
+    generic_list_node_t* firstNode;
+    uint32_t memStart = allocatedMem;
+
+    ck_assert_int_eq(nodeArena_create(&arena, 1, countingDestructor), LIST_SUCCESS);
+    ck_assert_uint_eq(arena.capacity, NODE_ARENA_HUGE_PAGE_SIZE);
+    ck_assert_uint_eq((uintptr_t)arena.base % NODE_ARENA_HUGE_PAGE_SIZE, 0);
+
+    ck_assert_int_eq(genericList_newList(&list, tracedFree, tracedMalloc), LIST_SUCCESS);
+    ck_assert_int_eq(nodeArena_attach(&arena, &list), LIST_SUCCESS);
+    for ( uint32_t i = 0; i < ARENA_TEST_ELEMENTS; i++ )
+    {
+        ck_assert_int_eq(genericList_append(&list, NULL), LIST_SUCCESS);
+    }
+    ck_assert_int_eq(genericList_insert(&list, NULL, 1), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_removeElementAt(&list, 2), LIST_SUCCESS);
+
+    /* Nodes are packed in the arena and never touch the list allocator */
+    ck_assert_int_eq(memStart, allocatedMem);
+    ck_assert_ptr_eq(list.head, arena.base);
+    ck_assert_uint_eq(arena.used, ( ARENA_TEST_ELEMENTS + 1 ) * sizeof(generic_list_node_t));
+
+    /* Dropping list runs destructor pass and frees nothing one by one */
+    destructorCalls = 0;
+    ck_assert_int_eq(nodeArena_freeList(&arena, &list), LIST_SUCCESS);
+    ck_assert_uint_eq(destructorCalls, ARENA_TEST_ELEMENTS);
+    ck_assert_ptr_eq(list.head, NULL);
+    ck_assert_ptr_eq(list.tail, NULL);
+    ck_assert_uint_eq(list.size, 0);
+
+    /* Reset hands out the same memory again */
+    ck_assert_int_eq(nodeArena_reset(&arena), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_append(&list, NULL), LIST_SUCCESS);
+    firstNode = list.head;
+    ck_assert_ptr_eq(firstNode, arena.base);
+
+    /* Exhausted arena reports no memory */
+    arena.used = arena.capacity;
+    ck_assert_int_eq(genericList_append(&list, NULL), LIST_NO_MEM);
+
+    /* Arena without destructor does not walk the list */
+    arena.destructor = NULL;
+    destructorCalls = 0;
+    ck_assert_int_eq(nodeArena_freeList(&arena, &list), LIST_SUCCESS);
+    ck_assert_uint_eq(destructorCalls, 0);
+
+    ck_assert_int_eq(nodeArena_destroy(&arena), LIST_SUCCESS);
+    ck_assert_int_eq(memStart, allocatedMem);
+}
+END_TEST
+
+Suite * node_arena_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("node-arena");
+
+    /* Core test case */
+    tc_core = tcase_create("Core");
+
+    tcase_add_test(tc_core, node_arena_bulk_free);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+#define KEYED_TEST_ELEMENTS     (150u)
+#define KEYED_TEST_KEYS         (10u)
+
+static uint64_t extractItemKey(const void* data)
+{
+    return *(const uint64_t*)data;
+}
+
+/* Low halves of all keys are equal, so only a full 64 bit compare tells them apart */
+static uint64_t makeKey(uint32_t i, keyed_list_width_t width)
+{
+    return ( KEYED_LIST_KEY64 == width ) ? ( ( (uint64_t)( i % KEYED_TEST_KEYS ) << 32 ) | 7u ) : ( i % KEYED_TEST_KEYS );
+}
+
+static void checkKeyedSearch(keyed_list_width_t width, keyed_list_kernel_t kernel)
+{
+    keyed_list_t list;
+    generic_list_node_t* nodes[KEYED_TEST_ELEMENTS];
+    generic_list_node_t* node;
+    generic_list_node_t* expected;
+    uint32_t memStart = allocatedMem;
+    size_t count;
+    size_t found;
+    uint64_t* item;
+
+    ck_assert_int_eq(keyedList_newList(&list, width, extractItemKey, tracedFree, tracedMalloc), LIST_SUCCESS);
+    if ( LIST_NOT_IMPLEMENTED == keyedList_setKernel(&list, kernel) )
+    {
+        /* Not supported by this CPU */
+        ck_assert_int_eq(keyedList_freeList(&list), LIST_SUCCESS);
+        return;
+    }
+    for ( uint32_t i = 0; i < KEYED_TEST_ELEMENTS; i++ )
+    {
+        item = (uint64_t*)tracedMalloc(sizeof(uint64_t));
+        ck_assert_ptr_ne(item, NULL);
+        *item = makeKey(i, width);
+        ck_assert_int_eq(keyedList_append(&list, item), LIST_SUCCESS);
+    }
+
+    /* Every key is held by 15 elements */
+    ck_assert_int_eq(keyedList_count(&list, makeKey(3, width), &count), LIST_SUCCESS);
+    ck_assert_uint_eq(count, KEYED_TEST_ELEMENTS / KEYED_TEST_KEYS);
+    /* Results come in list order even though matches span several blocks */
+    ck_assert_int_eq(keyedList_find(&list, makeKey(3, width), &node), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_getElementAt(&list.list, 3, &expected), LIST_SUCCESS);
+    ck_assert_ptr_eq(node, expected);
+    ck_assert_int_eq(keyedList_findAll(&list, makeKey(4, width), nodes, KEYED_TEST_ELEMENTS, &found), LIST_SUCCESS);
+    ck_assert_uint_eq(found, KEYED_TEST_ELEMENTS / KEYED_TEST_KEYS);
+    for ( size_t i = 0; i < found; i++ )
+    {
+        ck_assert_int_eq(genericList_getElementAt(&list.list, (unsigned int)( 4 + i * KEYED_TEST_KEYS ), &expected), LIST_SUCCESS);
+        ck_assert_ptr_eq(nodes[i], expected);
+    }
+    ck_assert_int_eq(keyedList_findAll(&list, makeKey(4, width), nodes, 2, &found), LIST_NO_MEM);
+    ck_assert_uint_eq(found, 2);
+    ck_assert_int_eq(keyedList_find(&list, makeKey(3, width) + 1000, &node), LIST_NOT_FOUND);
+    ck_assert_ptr_eq(node, NULL);
+
+    /* Removing through generic list updates key column, freed slots are reused */
+    ck_assert_int_eq(genericList_removeElementAt(&list.list, 3), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_removeElementAt(&list.list, 4), LIST_SUCCESS);
+    ck_assert_int_eq(keyedList_count(&list, makeKey(3, width), &count), LIST_SUCCESS);
+    ck_assert_uint_eq(count, KEYED_TEST_ELEMENTS / KEYED_TEST_KEYS - 1);
+    item = (uint64_t*)tracedMalloc(sizeof(uint64_t));
+    ck_assert_ptr_ne(item, NULL);
+    *item = makeKey(3, width);
+    ck_assert_int_eq(keyedList_insert(&list, item, 0), LIST_SUCCESS);
+    ck_assert_int_eq(keyedList_count(&list, makeKey(3, width), &count), LIST_SUCCESS);
+    ck_assert_uint_eq(count, KEYED_TEST_ELEMENTS / KEYED_TEST_KEYS);
+    ck_assert_ptr_eq(list.list.head->data, item);
+
+    /* Reused slot and middle insert no longer follow list order */
+    ck_assert_int_eq(keyedList_find(&list, makeKey(3, width), &node), LIST_SUCCESS);
+    ck_assert_ptr_eq(node, list.list.head);
+    ck_assert_int_eq(keyedList_findAll(&list, makeKey(3, width), nodes, KEYED_TEST_ELEMENTS, &found), LIST_SUCCESS);
+    ck_assert_uint_eq(found, KEYED_TEST_ELEMENTS / KEYED_TEST_KEYS);
+    found = 0;
+    for ( generic_list_node_t* walk = list.list.head; NULL != walk; walk = walk->next )
+    {
+        if ( makeKey(3, width) == *(uint64_t*)walk->data )
+        {
+            ck_assert_ptr_eq(nodes[found++], walk);
+        }
+    }
+    ck_assert_uint_eq(found, KEYED_TEST_ELEMENTS / KEYED_TEST_KEYS);
+
+    /* Elements can not be added bypassing the key column, not even after a failed insert */
+    item = (uint64_t*)tracedMalloc(sizeof(uint64_t));
+    ck_assert_ptr_ne(item, NULL);
+    *item = makeKey(5, width);
+    ck_assert_int_ne(keyedList_insert(&list, item, KEYED_TEST_ELEMENTS + 10), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_append(&list.list, item), LIST_NO_MEM);
+    ck_assert_int_eq(genericList_insert(&list.list, item, 0), LIST_NO_MEM);
+    ck_assert_uint_eq(list.list.size, KEYED_TEST_ELEMENTS - 1);
+    tracedFree(item);
+
+    ck_assert_int_eq(keyedList_freeList(&list), LIST_SUCCESS);
+    ck_assert_int_eq(memStart, allocatedMem);
+}
+
+START_TEST(keyed_list_search_32)
+{
+    checkKeyedSearch(KEYED_LIST_KEY32, KEYED_LIST_KERNEL_SCALAR);
+    checkKeyedSearch(KEYED_LIST_KEY32, KEYED_LIST_KERNEL_SSE2);
+    checkKeyedSearch(KEYED_LIST_KEY32, KEYED_LIST_KERNEL_AVX2);
+    checkKeyedSearch(KEYED_LIST_KEY32, KEYED_LIST_KERNEL_AUTO);
+}
+END_TEST
+
+START_TEST(keyed_list_search_64)
+{
+    checkKeyedSearch(KEYED_LIST_KEY64, KEYED_LIST_KERNEL_SCALAR);
+    checkKeyedSearch(KEYED_LIST_KEY64, KEYED_LIST_KERNEL_SSE2);
+    checkKeyedSearch(KEYED_LIST_KEY64, KEYED_LIST_KERNEL_AVX2);
+    checkKeyedSearch(KEYED_LIST_KEY64, KEYED_LIST_KERNEL_AUTO);
+}
+END_TEST
+
+Suite * keyed_list_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("keyed-list");
+
+    /* Core test case */
+    tc_core = tcase_create("Core");
+
+    tcase_add_test(tc_core, keyed_list_search_32);
+    tcase_add_test(tc_core, keyed_list_search_64);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+static uint64_t* newKey(uint64_t key)
+{
+    uint64_t* data = (uint64_t*)memTrace_malloc(sizeof(uint64_t));
+    *data = key;
+    return data;
+}
+
+typedef struct
+{
+    uint64_t keys[16];
+    size_t count;
+    uintptr_t failures;
+}concurrent_visit_t;
+
+/* Collects keys, counts keys out of order or not matching their data */
+static bool collectKeys(void* ctx, uint64_t key, void* data)
+{
+    concurrent_visit_t* visit = (concurrent_visit_t*)ctx;
+    if ( ( *(uint64_t*)data != key ) || ( ( 0 != visit->count ) && ( visit->keys[( visit->count - 1 ) % 16] >= key ) ) )
+    {
+        visit->failures++;
+    }
+    visit->keys[visit->count % 16] = key;
+    visit->count++;
+    return true;
+}
+
+START_TEST(concurrent_list_basic)
+{
+    concurrent_list_t list;
+    concurrent_list_handle_t* handle;
+    concurrent_list_handle_t* handles[CONCURRENT_LIST_MAX_THREADS];
+    concurrent_visit_t visit = { { 0 }, 0, 0 };
+    mem_trace_stats_t start;
+    mem_trace_stats_t stats;
+    const uint64_t keys[] = { 50, 10, 40, 20, 30 };
+    uint64_t* duplicate;
+    void* data;
+
+    ck_assert_int_eq(memTrace_getStats(&start), LIST_SUCCESS);
+    duplicate = newKey(20);
+    ck_assert_int_eq(concurrentList_newList(&list, memTrace_free, memTrace_malloc), LIST_SUCCESS);
+    ck_assert_int_eq(concurrentList_register(&list, &handle), LIST_SUCCESS);
+
+    for ( size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); i++ )
+    {
+        ck_assert_int_eq(concurrentList_insert(handle, keys[i], newKey(keys[i])), LIST_SUCCESS);
+    }
+    ck_assert_int_eq(concurrentList_insert(handle, 20, duplicate), LIST_EXISTS);
+    memTrace_free(duplicate);
+    ck_assert_uint_eq(concurrentList_size(&list), 5);
+
+    ck_assert_int_eq(concurrentList_find(handle, 40, &data), LIST_SUCCESS);
+    ck_assert_uint_eq(*(uint64_t*)data, 40);
+    ck_assert_int_eq(concurrentList_find(handle, 45, &data), LIST_NOT_FOUND);
+
+    /* Remove head, middle and tail */
+    ck_assert_int_eq(concurrentList_remove(handle, 10), LIST_SUCCESS);
+    ck_assert_int_eq(concurrentList_remove(handle, 30), LIST_SUCCESS);
+    ck_assert_int_eq(concurrentList_remove(handle, 50), LIST_SUCCESS);
+    ck_assert_int_eq(concurrentList_remove(handle, 50), LIST_NOT_FOUND);
+    ck_assert_int_eq(concurrentList_find(handle, 30, NULL), LIST_NOT_FOUND);
+
+    ck_assert_int_eq(concurrentList_forEach(handle, collectKeys, &visit), LIST_SUCCESS);
+    ck_assert_uint_eq(visit.count, 2);
+    ck_assert_uint_eq(visit.failures, 0);
+    ck_assert_uint_eq(visit.keys[0], 20);
+    ck_assert_uint_eq(visit.keys[1], 40);
+
+    /* All handles taken */
+    for ( unsigned int i = 1; i < CONCURRENT_LIST_MAX_THREADS; i++ )
+    {
+        ck_assert_int_eq(concurrentList_register(&list, &handles[i]), LIST_SUCCESS);
+    }
+    ck_assert_int_eq(concurrentList_register(&list, &handles[0]), LIST_NO_MEM);
+    for ( unsigned int i = 1; i < CONCURRENT_LIST_MAX_THREADS; i++ )
+    {
+        ck_assert_int_eq(concurrentList_unregister(handles[i]), LIST_SUCCESS);
+    }
+
+    /* Freeing needs all handles released, removed elements are freed too */
+    ck_assert_int_eq(concurrentList_freeList(&list), LIST_INVALID_PARAM);
+    ck_assert_int_eq(concurrentList_unregister(handle), LIST_SUCCESS);
+    ck_assert_int_eq(concurrentList_freeList(&list), LIST_SUCCESS);
+    ck_assert_uint_eq(concurrentList_size(&list), 0);
+    ck_assert_int_eq(memTrace_getStats(&stats), LIST_SUCCESS);
+    ck_assert_uint_eq(stats.liveBytes, start.liveBytes);
+}
+END_TEST
+
+#define CONCURRENT_THREADS          (8u)
+#define CONCURRENT_OPERATIONS       (100000u)
+#define CONCURRENT_PRIVATE_KEYS     (64u)
+#define CONCURRENT_SHARED_KEYS      (16u)
+/** Shared keys sort in between private keys of all threads */
+#define CONCURRENT_SHARED_STRIDE    (CONCURRENT_PRIVATE_KEYS * CONCURRENT_THREADS / CONCURRENT_SHARED_KEYS)
+
+typedef struct
+{
+    concurrent_list_t* list;
+    unsigned int id;
+    uint32_t seed;
+    bool present[CONCURRENT_PRIVATE_KEYS];
+    uintptr_t failures;
+}concurrent_worker_t;
+
+static _Atomic(uint64_t) sharedInserts[CONCURRENT_SHARED_KEYS];
+static _Atomic(uint64_t) sharedRemoves[CONCURRENT_SHARED_KEYS];
+
+static uint64_t privateKey(unsigned int id, uint32_t index)
+{
+    return (uint64_t)( index * CONCURRENT_THREADS + id ) * 2u + 1u;
+}
+
+static uint64_t sharedKey(uint32_t index)
+{
+    return (uint64_t)index * CONCURRENT_SHARED_STRIDE * 2u;
+}
+
+/* Private keys have only one writer, so the result of every operation on
+ * them is known. Shared keys are raced for, successes are counted */
+static void* concurrentWorker(void* arg)
+{
+    concurrent_worker_t* worker = (concurrent_worker_t*)arg;
+    concurrent_list_handle_t* handle;
+
+    if ( LIST_SUCCESS != concurrentList_register(worker->list, &handle) )
+    {
+        worker->failures++;
+        return NULL;
+    }
+    for ( uint32_t i = 0; i < CONCURRENT_OPERATIONS; i++ )
+    {
+        uint32_t r;
+        worker->seed ^= worker->seed << 13;
+        worker->seed ^= worker->seed >> 17;
+        worker->seed ^= worker->seed << 5;
+        r = worker->seed;
+
+        if ( 0 == ( r & 3u ) )
+        {
+            uint32_t index = ( r >> 8 ) % CONCURRENT_SHARED_KEYS;
+            uint64_t key = sharedKey(index);
+            if ( r & 4u )
+            {
+                uint64_t* data = newKey(key);
+                if ( LIST_SUCCESS == concurrentList_insert(handle, key, data) )
+                {
+                    atomic_fetch_add(&sharedInserts[index], 1);
+                }
+                else
+                {
+                    memTrace_free(data);
+                }
+            }
+            else if ( LIST_SUCCESS == concurrentList_remove(handle, key) )
+            {
+                atomic_fetch_add(&sharedRemoves[index], 1);
+            }
+        }
+        else
+        {
+            uint32_t index = ( r >> 8 ) % CONCURRENT_PRIVATE_KEYS;
+            uint64_t key = privateKey(worker->id, index);
+            void* data;
+            list_error_t err;
+            switch ( r & 3u )
+            {
+            case 1:
+                data = newKey(key);
+                err = concurrentList_insert(handle, key, data);
+                worker->failures += ( err != ( worker->present[index] ? LIST_EXISTS : LIST_SUCCESS ) );
+                if ( LIST_SUCCESS != err )
+                {
+                    memTrace_free(data);
+                }
+                worker->present[index] = true;
+                break;
+            case 2:
+                err = concurrentList_remove(handle, key);
+                worker->failures += ( err != ( worker->present[index] ? LIST_SUCCESS : LIST_NOT_FOUND ) );
+                worker->present[index] = false;
+                break;
+            default:
+                err = concurrentList_find(handle, key, &data);
+                worker->failures += ( err != ( worker->present[index] ? LIST_SUCCESS : LIST_NOT_FOUND ) );
+                worker->failures += ( ( LIST_SUCCESS == err ) && ( *(uint64_t*)data != key ) );
+                break;
+            }
+        }
+        if ( 0 == ( i % 1000u ) )
+        {
+            concurrent_visit_t visit = { { 0 }, 0, 0 };
+            (void)concurrentList_forEach(handle, collectKeys, &visit);
+            worker->failures += visit.failures;
+        }
+    }
+    (void)concurrentList_unregister(handle);
+    return NULL;
+}
+
+START_TEST(concurrent_list_stress)
+{
+    concurrent_list_t list;
+    concurrent_list_handle_t* handle;
+    concurrent_worker_t workers[CONCURRENT_THREADS];
+    pthread_t threads[CONCURRENT_THREADS];
+    concurrent_visit_t visit = { { 0 }, 0, 0 };
+    mem_trace_stats_t start;
+    mem_trace_stats_t stats;
+    size_t expected = 0;
+
+    ck_assert_int_eq(memTrace_getStats(&start), LIST_SUCCESS);
+    ck_assert_int_eq(concurrentList_newList(&list, memTrace_free, memTrace_malloc), LIST_SUCCESS);
+    for ( unsigned int k = 0; k < CONCURRENT_SHARED_KEYS; k++ )
+    {
+        atomic_store(&sharedInserts[k], 0);
+        atomic_store(&sharedRemoves[k], 0);
+    }
+    for ( unsigned int t = 0; t < CONCURRENT_THREADS; t++ )
+    {
+        memset(&workers[t], 0, sizeof(workers[t]));
+        workers[t].list = &list;
+        workers[t].id = t;
+        workers[t].seed = 2463534242u + t;
+        ck_assert_int_eq(pthread_create(&threads[t], NULL, concurrentWorker, &workers[t]), 0);
+    }
+    for ( unsigned int t = 0; t < CONCURRENT_THREADS; t++ )
+    {
+        pthread_join(threads[t], NULL);
+        ck_assert_uint_eq(workers[t].failures, 0);
+    }
+
+    /* Final contents match what every operation reported */
+    ck_assert_int_eq(concurrentList_register(&list, &handle), LIST_SUCCESS);
+    for ( unsigned int t = 0; t < CONCURRENT_THREADS; t++ )
+    {
+        for ( uint32_t i = 0; i < CONCURRENT_PRIVATE_KEYS; i++ )
+        {
+            list_error_t err = concurrentList_find(handle, privateKey(t, i), NULL);
+            ck_assert_int_eq(err, workers[t].present[i] ? LIST_SUCCESS : LIST_NOT_FOUND);
+            expected += workers[t].present[i];
+        }
+    }
+    for ( uint32_t k = 0; k < CONCURRENT_SHARED_KEYS; k++ )
+    {
+        uint64_t live = atomic_load(&sharedInserts[k]) - atomic_load(&sharedRemoves[k]);
+        ck_assert_uint_le(live, 1);
+        ck_assert_int_eq(concurrentList_find(handle, sharedKey(k), NULL), live ? LIST_SUCCESS : LIST_NOT_FOUND);
+        expected += live;
+    }
+    ck_assert_int_eq(concurrentList_forEach(handle, collectKeys, &visit), LIST_SUCCESS);
+    ck_assert_uint_eq(visit.failures, 0);
+    ck_assert_uint_eq(visit.count, expected);
+    ck_assert_uint_eq(concurrentList_size(&list), expected);
+
+    ck_assert_int_eq(concurrentList_unregister(handle), LIST_SUCCESS);
+    ck_assert_int_eq(concurrentList_freeList(&list), LIST_SUCCESS);
+    ck_assert_int_eq(memTrace_getStats(&stats), LIST_SUCCESS);
+    ck_assert_uint_eq(stats.liveBytes, start.liveBytes);
+    ck_assert_uint_eq(stats.invalidFrees, start.invalidFrees);
+}
+END_TEST
+
+Suite * concurrent_list_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("concurrent-list");
+
+    /* Core test case */
+    tc_core = tcase_create("Core");
+    tcase_set_timeout(tc_core, 60);
+
+    tcase_add_test(tc_core, concurrent_list_basic);
+    tcase_add_test(tc_core, concurrent_list_stress);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+#define VIEW_TEST_ELEMENTS      (20u)
+
+typedef struct
+{
+    size_t calls;
+    uint8_t results[VIEW_TEST_ELEMENTS];
+    size_t used;
+}view_ctx_t;
+
+static bool isEven(void* ctx, const void* data)
+{
+    ((view_ctx_t*)ctx)->calls++;
+    return ( 0 == ( *(const uint8_t*)data % 2u ) );
+}
+
+/* Results are stored in ctx, the view never owns data */
+static void* timesThree(void* ctx, void* data)
+{
+    view_ctx_t* view = (view_ctx_t*)ctx;
+    uint8_t* result = &view->results[view->used++ % VIEW_TEST_ELEMENTS];
+    *result = (uint8_t)( *(uint8_t*)data * 3u );
+    return result;
+}
+
+static void* sum(void* ctx, void* first, void* second)
+{
+    view_ctx_t* view = (view_ctx_t*)ctx;
+    uint8_t* result = &view->results[view->used++ % VIEW_TEST_ELEMENTS];
+    *result = (uint8_t)( *(uint8_t*)first + *(uint8_t*)second );
+    return result;
+}
+
+static bool stopAtFive(void* ctx, void* data)
+{
+    (*(size_t*)ctx)++;
+    return ( 5u != *(uint8_t*)data );
+}
+
+/* Collected data is owned by the target list */
+static void* sumCopy(void* ctx, void* first, void* second)
+{
+    (void)ctx;
+    return newByte((uint8_t)( *(uint8_t*)first + *(uint8_t*)second ));
+}
+
+static void* failingNodeAlloc(void* ctx, size_t size)
+{
+    (void)ctx;
+    (void)size;
+    return NULL;
+}
+
+static void unusedNodeFree(void* ctx, void* node)
+{
+    (void)ctx;
+    (void)node;
+}
+
+START_TEST(list_view_pipeline)
+{
+    generic_list_t list;
+    list_view_t source;
+    list_view_t skip;
+    list_view_t filter;
+    list_view_t map;
+    list_view_t take;
+    view_ctx_t filterCtx = { 0 };
+    view_ctx_t mapCtx = { 0 };
+    mem_trace_stats_t before;
+    mem_trace_stats_t after;
+    const uint8_t expected[] = { 12, 18, 24 };
+    void* data;
+
+    ck_assert_int_eq(genericList_newList(&list, tracedFree, tracedMalloc), LIST_SUCCESS);
+    for ( uint8_t i = 0; i < VIEW_TEST_ELEMENTS; i++ )
+    {
+        ck_assert_int_eq(genericList_append(&list, newByte(i)), LIST_SUCCESS);
+    }
+
+    /* skip 3 -> even -> times 3 -> take 3 */
+    ck_assert_int_eq(listView_source(&source, &list), LIST_SUCCESS);
+    ck_assert_int_eq(listView_skip(&skip, &source, 3), LIST_SUCCESS);
+    ck_assert_int_eq(listView_filter(&filter, &skip, isEven, &filterCtx), LIST_SUCCESS);
+    ck_assert_int_eq(listView_map(&map, &filter, timesThree, &mapCtx), LIST_SUCCESS);
+    ck_assert_int_eq(listView_take(&take, &map, 3), LIST_SUCCESS);
+
+    /* Nothing is evaluated before pulling and pulling allocates nothing */
+    ck_assert_uint_eq(filterCtx.calls, 0);
+    ck_assert_int_eq(memTrace_getStats(&before), LIST_SUCCESS);
+    for ( size_t i = 0; i < sizeof(expected); i++ )
+    {
+        ck_assert_int_eq(listView_next(&take, &data), LIST_SUCCESS);
+        ck_assert_uint_eq(*(uint8_t*)data, expected[i]);
+    }
+    ck_assert_int_eq(listView_next(&take, &data), LIST_NOT_FOUND);
+    ck_assert_int_eq(memTrace_getStats(&after), LIST_SUCCESS);
+    ck_assert_uint_eq(after.allocCount, before.allocCount);
+
+    /* Elements 3..8 were read, take stopped pulling after the third result */
+    ck_assert_uint_eq(filterCtx.calls, 6);
+    ck_assert_uint_eq(mapCtx.used, 3);
+
+    /* Skipping past the end */
+    ck_assert_int_eq(listView_source(&source, &list), LIST_SUCCESS);
+    ck_assert_int_eq(listView_skip(&skip, &source, VIEW_TEST_ELEMENTS + 1), LIST_SUCCESS);
+    ck_assert_int_eq(listView_next(&skip, &data), LIST_NOT_FOUND);
+
+    ck_assert_int_eq(genericList_freeList(&list), LIST_SUCCESS);
+    ck_assert_uint_eq(allocatedMem, 0);
+}
+END_TEST
+
+START_TEST(list_view_reverse_zip_collect)
+{
+    generic_list_t list;
+    generic_list_t collected;
+    list_view_t forward;
+    list_view_t backward;
+    list_view_t zip;
+    list_view_t take;
+    view_ctx_t zipCtx = { 0 };
+    size_t visited = 0;
+    size_t count;
+    void* data;
+
+    ck_assert_int_eq(genericList_newList(&list, tracedFree, tracedMalloc), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_newList(&collected, tracedFree, tracedMalloc), LIST_SUCCESS);
+    for ( uint8_t i = 0; i < VIEW_TEST_ELEMENTS; i++ )
+    {
+        ck_assert_int_eq(genericList_append(&list, newByte(i)), LIST_SUCCESS);
+    }
+
+    /* First and last element pairwise always sum up to the same value */
+    ck_assert_int_eq(listView_source(&forward, &list), LIST_SUCCESS);
+    ck_assert_int_eq(listView_reverse(&backward, &list), LIST_SUCCESS);
+    ck_assert_int_eq(listView_zip(&zip, &forward, &backward, sumCopy, NULL), LIST_SUCCESS);
+    ck_assert_int_eq(listView_collect(&zip, &collected, &data), LIST_SUCCESS);
+    ck_assert_ptr_eq(data, NULL);
+    ck_assert_uint_eq(collected.size, VIEW_TEST_ELEMENTS);
+    genericList_rewind(&collected);
+    while ( !genericList_isAtEnd(&collected) )
+    {
+        ck_assert_int_eq(genericList_getCurrentData(&collected, &data), LIST_SUCCESS);
+        ck_assert_uint_eq(*(uint8_t*)data, VIEW_TEST_ELEMENTS - 1);
+        genericList_next(&collected);
+    }
+
+    /* Element which could not be appended is handed back */
+    ck_assert_int_eq(genericList_freeList(&collected), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_newList(&collected, tracedFree, tracedMalloc), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_setNodeAllocator(&collected, failingNodeAlloc, unusedNodeFree, NULL), LIST_SUCCESS);
+    ck_assert_int_eq(listView_source(&forward, &list), LIST_SUCCESS);
+    ck_assert_int_eq(listView_reverse(&backward, &list), LIST_SUCCESS);
+    ck_assert_int_eq(listView_zip(&zip, &forward, &backward, sumCopy, NULL), LIST_SUCCESS);
+    ck_assert_int_eq(listView_collect(&zip, &collected, &data), LIST_NO_MEM);
+    ck_assert_ptr_ne(data, NULL);
+    ck_assert_uint_eq(*(uint8_t*)data, VIEW_TEST_ELEMENTS - 1);
+    tracedFree(data);
+    ck_assert_uint_eq(collected.size, 0);
+
+    /* Source elements stay owned by their list, with or without stages passing them through */
+    ck_assert_int_eq(listView_source(&forward, &list), LIST_SUCCESS);
+    ck_assert_int_eq(listView_collect(&forward, &collected, &data), LIST_INVALID_PARAM);
+    ck_assert_ptr_eq(data, NULL);
+    ck_assert_int_eq(listView_take(&take, &forward, 4), LIST_SUCCESS);
+    ck_assert_int_eq(listView_collect(&take, &collected, &data), LIST_INVALID_PARAM);
+    ck_assert_ptr_eq(data, NULL);
+    ck_assert_uint_eq(collected.size, 0);
+    ck_assert_int_eq(listView_next(&forward, &data), LIST_SUCCESS);
+    ck_assert_uint_eq(*(uint8_t*)data, 0);
+
+    /* Zip ends with the shorter view */
+    ck_assert_int_eq(listView_source(&forward, &list), LIST_SUCCESS);
+    ck_assert_int_eq(listView_take(&take, &forward, 4), LIST_SUCCESS);
+    ck_assert_int_eq(listView_reverse(&backward, &list), LIST_SUCCESS);
+    ck_assert_int_eq(listView_zip(&zip, &backward, &take, sum, &zipCtx), LIST_SUCCESS);
+    ck_assert_int_eq(listView_count(&zip, &count), LIST_SUCCESS);
+    ck_assert_uint_eq(count, 4);
+
+    /* forEach stops when visitor says so */
+    ck_assert_int_eq(listView_source(&forward, &list), LIST_SUCCESS);
+    ck_assert_int_eq(listView_forEach(&forward, stopAtFive, &visited), LIST_SUCCESS);
+    ck_assert_uint_eq(visited, 6);
+    ck_assert_int_eq(listView_next(&forward, &data), LIST_SUCCESS);
+    ck_assert_uint_eq(*(uint8_t*)data, 6);
+
+#if !defined(GENERIC_LIST_UNCHECKED)
+    ck_assert_int_eq(listView_source(NULL, &list), LIST_INVALID_PARAM);
+    ck_assert_int_eq(listView_filter(&take, &forward, NULL, NULL), LIST_INVALID_PARAM);
+    ck_assert_int_eq(listView_zip(&zip, &forward, &forward, sum, NULL), LIST_INVALID_PARAM);
+    ck_assert_int_eq(listView_collect(&zip, &collected, NULL), LIST_INVALID_PARAM);
+#endif
+
+    ck_assert_int_eq(genericList_freeList(&collected), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_freeList(&list), LIST_SUCCESS);
+    ck_assert_uint_eq(allocatedMem, 0);
+}
+END_TEST
+
+Suite * list_view_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("list-view");
+
+    /* Core test case */
+    tc_core = tcase_create("Core");
+
+    tcase_add_test(tc_core, list_view_pipeline);
+    tcase_add_test(tc_core, list_view_reverse_zip_collect);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+#define METRICS_TEST_VALUES     (1000u)
+
+START_TEST(list_metrics_histogram)
+{
+    list_metrics_t* metrics;
+    list_op_stats_t stats;
+    uint64_t ns;
+    char* text = NULL;
+    size_t length = 0;
+    FILE* out;
+
+    ck_assert_int_eq(listMetrics_newMetrics(&metrics, tracedFree, tracedMalloc), LIST_SUCCESS);
+    ck_assert_int_eq(listMetrics_percentile(metrics, LIST_OP_APPEND, 50.0, &ns), LIST_EMPTY);
+
+    /* Small values are exact */
+    for ( uint64_t i = 0; i < 8; i++ )
+    {
+        ck_assert_int_eq(listMetrics_record(metrics, LIST_OP_INSERT, i), LIST_SUCCESS);
+    }
+    ck_assert_int_eq(listMetrics_percentile(metrics, LIST_OP_INSERT, 50.0, &ns), LIST_SUCCESS);
+    ck_assert_uint_eq(ns, 3);
+
+    /* Larger ones are known within 12.5% */
+    for ( uint64_t i = 1; i <= METRICS_TEST_VALUES; i++ )
+    {
+        ck_assert_int_eq(listMetrics_record(metrics, LIST_OP_APPEND, i * 1000u), LIST_SUCCESS);
+    }
+    ck_assert_int_eq(listMetrics_percentile(metrics, LIST_OP_APPEND, 50.0, &ns), LIST_SUCCESS);
+    ck_assert_uint_ge(ns, 500000u);
+    ck_assert_uint_le(ns, 500000u + 500000u / 8u);
+    ck_assert_int_eq(listMetrics_percentile(metrics, LIST_OP_APPEND, 99.0, &ns), LIST_SUCCESS);
+    ck_assert_uint_ge(ns, 990000u);
+    ck_assert_uint_le(ns, 990000u + 990000u / 8u);
+    ck_assert_int_eq(listMetrics_percentile(metrics, LIST_OP_APPEND, 100.0, &ns), LIST_SUCCESS);
+    ck_assert_uint_eq(ns, 1000000u);
+    ck_assert_int_eq(listMetrics_getStats(metrics, LIST_OP_APPEND, &stats), LIST_SUCCESS);
+    ck_assert_uint_eq(stats.count, METRICS_TEST_VALUES);
+    ck_assert_uint_eq(stats.sumNs, 1000u * METRICS_TEST_VALUES * ( METRICS_TEST_VALUES + 1u ) / 2u);
+    ck_assert_uint_eq(stats.maxNs, 1000000u);
+
+    /* Largest values still land in a bucket */
+    ck_assert_int_eq(listMetrics_record(metrics, LIST_OP_FREE_LIST, UINT64_MAX), LIST_SUCCESS);
+    ck_assert_int_eq(listMetrics_percentile(metrics, LIST_OP_FREE_LIST, 50.0, &ns), LIST_SUCCESS);
+    ck_assert_uint_eq(ns, UINT64_MAX);
+
+    out = open_memstream(&text, &length);
+    ck_assert_ptr_ne(out, NULL);
+    ck_assert_int_eq(listMetrics_export(metrics, LIST_METRICS_JSON, out), LIST_SUCCESS);
+    fclose(out);
+    ck_assert_ptr_ne(strstr(text, "\"append\":{\"count\":1000,"), NULL);
+    ck_assert_ptr_ne(strstr(text, "\"insert\":{\"count\":8,"), NULL);
+    ck_assert_ptr_ne(strstr(text, "\"buckets\":[[0,1],[1,1]"), NULL);
+    free(text);
+
+    out = open_memstream(&text, &length);
+    ck_assert_ptr_ne(out, NULL);
+    ck_assert_int_eq(listMetrics_export(metrics, LIST_METRICS_TEXT, out), LIST_SUCCESS);
+    fclose(out);
+    ck_assert_ptr_ne(strstr(text, "removeElementAt"), NULL);
+    free(text);
+
+#if !defined(GENERIC_LIST_UNCHECKED)
+    ck_assert_int_eq(listMetrics_record(metrics, LIST_OP_COUNT, 1), LIST_INVALID_PARAM);
+    ck_assert_int_eq(listMetrics_percentile(metrics, LIST_OP_APPEND, 101.0, &ns), LIST_INVALID_PARAM);
+    ck_assert_int_eq(listMetrics_getStats(metrics, LIST_OP_COUNT, &stats), LIST_INVALID_PARAM);
+    ck_assert_int_eq(listMetrics_freeMetrics(listMetrics_global()), LIST_INVALID_PARAM);
+#endif
+
+    ck_assert_int_eq(listMetrics_freeMetrics(metrics), LIST_SUCCESS);
+}
+END_TEST
+
+/* Operations done by list_metrics_operations, indexed by list_op_t */
+static const uint64_t expectedCounts[LIST_OP_COUNT] = { 10, 2, 1, 1, 1 };
+
+START_TEST(list_metrics_operations)
+{
+    list_metrics_t* metrics;
+    list_op_stats_t stats;
+    generic_list_t list;
+    void* data;
+    /* Without instrumentation nothing is recorded */
+#if defined(GENERIC_LIST_INSTRUMENT)
+    const uint64_t scale = 1;
+#else
+    const uint64_t scale = 0;
+#endif
+
+    ck_assert_int_eq(listMetrics_newMetrics(&metrics, tracedFree, tracedMalloc), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_newList(&list, tracedFree, tracedMalloc), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_setMetrics(&list, metrics), LIST_SUCCESS);
+
+    for ( uint8_t i = 0; i < 10; i++ )
+    {
+        ck_assert_int_eq(genericList_append(&list, newByte(i)), LIST_SUCCESS);
+    }
+    /* Insert at the end is counted once, as insert */
+    ck_assert_int_eq(genericList_insert(&list, newByte(10), 10), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_insert(&list, newByte(11), 0), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_getDataAt(&list, 3, &data), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_removeElementAt(&list, 3), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_freeList(&list), LIST_SUCCESS);
+
+    for ( unsigned int op = 0; op < LIST_OP_COUNT; op++ )
+    {
+        ck_assert_int_eq(listMetrics_getStats(metrics, (list_op_t)op, &stats), LIST_SUCCESS);
+        ck_assert_uint_eq(stats.count, expectedCounts[op] * scale);
+    }
+    ck_assert_int_eq(listMetrics_getStats(listMetrics_global(), LIST_OP_APPEND, &stats), LIST_SUCCESS);
+    ck_assert_uint_ge(stats.count, 10 * scale);
+    ck_assert_int_eq(listMetrics_freeMetrics(metrics), LIST_SUCCESS);
+    ck_assert_uint_eq(allocatedMem, 0);
+}
+END_TEST
+
+Suite * list_metrics_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("list-metrics");
+
+    /* Core test case */
+    tc_core = tcase_create("Core");
+
+    tcase_add_test(tc_core, list_metrics_histogram);
+    tcase_add_test(tc_core, list_metrics_operations);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+#define COMPLEXITY_ELEMENTS         (2000000u)
+#define COMPLEXITY_SORTED_ELEMENTS  (1000000u)
+#define COMPLEXITY_LOOKUPS          (10000u)
+/** Hash table probes per tracked allocation or free, rehashing included */
+#define MAX_PROBES_PER_OPERATION    (4.0)
+/** Comparisons per sorted operation relative to log2(n) */
+#define MAX_COMPARISONS_PER_LOG2    (4.0)
+
+static size_t comparisons;
+
+static int countingCompare(const void* a, const void* b)
+{
+    uint32_t keyA = *(const uint32_t*)a;
+    uint32_t keyB = *(const uint32_t*)b;
+    comparisons++;
+    return ( keyA > keyB ) - ( keyA < keyB );
+}
+
+START_TEST(complexity_append_traverse_free)
+{
+    generic_list_t list;
+    mem_trace_stats_t start;
+    mem_trace_stats_t stats;
+    size_t steps = 0;
+
+    ck_assert_int_eq(memTrace_resetPeak(), LIST_SUCCESS);
+    ck_assert_int_eq(memTrace_getStats(&start), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_newList(&list, memTrace_free, memTrace_malloc), LIST_SUCCESS);
+
+    /* Exactly one allocation of one node per append */
+    for ( uint32_t i = 0; i < COMPLEXITY_ELEMENTS; i++ )
+    {
+        ck_assert_int_eq(genericList_append(&list, NULL), LIST_SUCCESS);
+    }
+    ck_assert_int_eq(memTrace_getStats(&stats), LIST_SUCCESS);
+    ck_assert_uint_eq(stats.allocCount - start.allocCount, COMPLEXITY_ELEMENTS);
+    ck_assert_uint_eq(stats.liveBytes - start.liveBytes, COMPLEXITY_ELEMENTS * sizeof(generic_list_node_t));
+    ck_assert_uint_eq(stats.peakBytes, stats.liveBytes);
+
+    /* Traversal takes one step per element and allocates nothing */
+    genericList_rewind(&list);
+    while ( !genericList_isAtEnd(&list) )
+    {
+        steps++;
+        genericList_next(&list);
+    }
+    ck_assert_uint_eq(steps, COMPLEXITY_ELEMENTS);
+
+    /* Removing from head is O(1) and keeps size right */
+    for ( uint32_t i = 0; i < COMPLEXITY_ELEMENTS / 2; i++ )
+    {
+        ck_assert_int_eq(genericList_removeElementAt(&list, 0), LIST_SUCCESS);
+    }
+    ck_assert_uint_eq(list.size, COMPLEXITY_ELEMENTS / 2);
+
+    /* Every node is freed exactly once */
+    ck_assert_int_eq(genericList_freeList(&list), LIST_SUCCESS);
+    ck_assert_int_eq(memTrace_getStats(&stats), LIST_SUCCESS);
+    ck_assert_uint_eq(stats.allocCount - start.allocCount, COMPLEXITY_ELEMENTS);
+    ck_assert_uint_eq(stats.freeCount - start.freeCount, COMPLEXITY_ELEMENTS);
+    ck_assert_uint_eq(stats.liveBytes, start.liveBytes);
+    ck_assert_uint_eq(stats.liveBlocks, start.liveBlocks);
+    ck_assert_uint_eq(stats.invalidFrees, start.invalidFrees);
+
+    /* Tracker itself stays O(1) per operation */
+    ck_assert_double_le((double)( stats.probes - start.probes ) / ( 2.0 * COMPLEXITY_ELEMENTS ), MAX_PROBES_PER_OPERATION);
+}
+END_TEST
+
+/** Sizes compared by linear scaling test, each 10 times the previous one */
+static const size_t linearSizes[] = { 10000u, 100000u, 1000000u };
+/** Allowed growth of tracker probes per operation between two sizes */
+#define MAX_PROBE_GROWTH            (1.5)
+
+START_TEST(complexity_linear_scaling)
+{
+    double probesPerOp[sizeof(linearSizes) / sizeof(linearSizes[0])];
+
+    for ( size_t n = 0; n < sizeof(linearSizes) / sizeof(linearSizes[0]); n++ )
+    {
+        const size_t elements = linearSizes[n];
+        generic_list_t list;
+        generic_list_node_t* node;
+        mem_trace_stats_t start;
+        mem_trace_stats_t appended;
+        mem_trace_stats_t stats;
+        size_t steps = 0;
+
+        ck_assert_int_eq(memTrace_getStats(&start), LIST_SUCCESS);
+        ck_assert_int_eq(genericList_newList(&list, memTrace_free, memTrace_malloc), LIST_SUCCESS);
+        for ( size_t i = 0; i < elements; i++ )
+        {
+            ck_assert_int_eq(genericList_append(&list, NULL), LIST_SUCCESS);
+        }
+        ck_assert_int_eq(memTrace_getStats(&appended), LIST_SUCCESS);
+        for ( node = list.head; NULL != node; node = node->next )
+        {
+            steps++;
+        }
+        ck_assert_int_eq(genericList_freeList(&list), LIST_SUCCESS);
+        ck_assert_int_eq(memTrace_getStats(&stats), LIST_SUCCESS);
+
+        /* Same work per element at every size: one allocation, one step and one free */
+        ck_assert_uint_eq(appended.allocCount - start.allocCount, elements);
+        ck_assert_uint_eq(appended.liveBytes - start.liveBytes, elements * sizeof(generic_list_node_t));
+        ck_assert_uint_eq(steps, elements);
+        ck_assert_uint_eq(stats.freeCount - start.freeCount, elements);
+        ck_assert_uint_eq(stats.liveBytes, start.liveBytes);
+
+        /* Accounting work per operation does not grow with size either */
+        probesPerOp[n] = (double)( stats.probes - start.probes ) / ( 2.0 * elements );
+        if ( n > 0 )
+        {
+            ck_assert_double_le(probesPerOp[n] / probesPerOp[n - 1], MAX_PROBE_GROWTH);
+        }
+    }
+}
+END_TEST
+
+START_TEST(complexity_sorted_logarithmic)
+{
+    sorted_list_t list;
+    mem_trace_stats_t start;
+    mem_trace_stats_t stats;
+    double maxComparisons = MAX_COMPARISONS_PER_LOG2 * log2((double)COMPLEXITY_SORTED_ELEMENTS);
+    uint32_t seed = 1;
+
+    ck_assert_int_eq(memTrace_getStats(&start), LIST_SUCCESS);
+    ck_assert_int_eq(sortedList_newList(&list, countingCompare, memTrace_free, memTrace_malloc), LIST_SUCCESS);
+
+    comparisons = 0;
+    for ( uint32_t i = 0; i < COMPLEXITY_SORTED_ELEMENTS; i++ )
+    {
+        uint32_t* key = (uint32_t*)memTrace_malloc(sizeof(uint32_t));
+        ck_assert_ptr_ne(key, NULL);
+        seed = seed * 1103515245u + 12345u;
+        *key = seed;
+        ck_assert_int_eq(sortedList_insertSorted(&list, key), LIST_SUCCESS);
+    }
+    ck_assert_double_le((double)comparisons / COMPLEXITY_SORTED_ELEMENTS, maxComparisons);
+
+    /* Data, node and on average 1/3 of a tower per element */
+    ck_assert_int_eq(memTrace_getStats(&stats), LIST_SUCCESS);
+    ck_assert_uint_le(stats.allocCount - start.allocCount, 2 * COMPLEXITY_SORTED_ELEMENTS + COMPLEXITY_SORTED_ELEMENTS / 2);
+
+    comparisons = 0;
+    for ( uint32_t i = 0; i < COMPLEXITY_LOOKUPS; i++ )
+    {
+        generic_list_node_t* node;
+        uint32_t key = i * 429497u;
+        (void)sortedList_lowerBound(&list, &key, &node);
+    }
+    ck_assert_double_le((double)comparisons / COMPLEXITY_LOOKUPS, maxComparisons);
+
+    ck_assert_int_eq(sortedList_freeList(&list), LIST_SUCCESS);
+    ck_assert_int_eq(memTrace_getStats(&stats), LIST_SUCCESS);
+    ck_assert_uint_eq(stats.liveBytes, start.liveBytes);
+    ck_assert_uint_eq(stats.allocCount - start.allocCount, stats.freeCount - start.freeCount);
+}
+END_TEST
+
+START_TEST(mem_trace_report)
+{
+    mem_trace_stats_t start;
+    mem_trace_stats_t stats;
+    void* blocks[3];
+    int dummy;
+
+    ck_assert_int_eq(memTrace_getStats(&start), LIST_SUCCESS);
+    for ( int i = 0; i < 3; i++ )
+    {
+        blocks[i] = memTrace_malloc(100);
+        ck_assert_ptr_ne(blocks[i], NULL);
+    }
+    ck_assert_uint_eq(memTrace_reportLeaks(NULL), start.liveBlocks + 3);
+    memTrace_free(blocks[1]);
+    memTrace_free(&dummy);
+    memTrace_free(NULL);
+
+    ck_assert_int_eq(memTrace_getStats(&stats), LIST_SUCCESS);
+    ck_assert_uint_eq(stats.liveBytes - start.liveBytes, 200);
+    ck_assert_uint_ge(stats.peakBytes - start.liveBytes, 300);
+    ck_assert_uint_eq(stats.invalidFrees - start.invalidFrees, 1);
+    ck_assert_uint_eq(memTrace_reportLeaks(NULL), start.liveBlocks + 2);
+
+    memTrace_free(blocks[0]);
+    memTrace_free(blocks[2]);
+    ck_assert_uint_eq(memTrace_reportLeaks(NULL), start.liveBlocks);
+}
+END_TEST
+
+/* Opt-in, GENERIC_LIST_LARGE_ELEMENTS=100000000 needs 2.4 GB */
+START_TEST(complexity_large_scale)
+{
+    const char* env = getenv("GENERIC_LIST_LARGE_ELEMENTS");
+    size_t elements = ( NULL != env ) ? strtoull(env, NULL, 10) : 0;
+    node_arena_t arena;
+    generic_list_t list;
+    generic_list_node_t* node;
+    size_t steps = 0;
+
+    if ( elements < 2 )
+    {
+        return;
+    }
+    ck_assert_int_eq(nodeArena_create(&arena, elements * sizeof(generic_list_node_t), NULL), LIST_SUCCESS);
+    ck_assert_int_eq(genericList_newList(&list, free, malloc), LIST_SUCCESS);
+    ck_assert_int_eq(nodeArena_attach(&arena, &list), LIST_SUCCESS);
+
+    for ( size_t i = 0; i < elements; i++ )
+    {
+        ck_assert_int_eq(genericList_append(&list, NULL), LIST_SUCCESS);
+    }
+    ck_assert_uint_eq(list.size, elements);
+    for ( node = list.head; NULL != node; node = node->next )
+    {
+        steps++;
+    }
+    ck_assert_uint_eq(steps, elements);
+
+    /* Last positions are reached from the tail */
+    ck_assert_int_eq(genericList_getElementAt64(&list, elements - 1, &node), LIST_SUCCESS);
+    ck_assert_ptr_eq(node, list.tail);
+    ck_assert_int_eq(genericList_removeElementAt64(&list, elements - 2), LIST_SUCCESS);
+    ck_assert_uint_eq(list.size, elements - 1);
+
+    ck_assert_int_eq(genericList_freeList(&list), LIST_SUCCESS);
+    ck_assert_ptr_eq(list.head, NULL);
+    ck_assert_int_eq(nodeArena_destroy(&arena), LIST_SUCCESS);
+}
+END_TEST
+
+Suite * complexity_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("complexity");
+
+    /* Core test case */
+    tc_core = tcase_create("Complexity");
+    tcase_set_timeout(tc_core, 120);
+
+    tcase_add_test(tc_core, mem_trace_report);
+    tcase_add_test(tc_core, complexity_append_traverse_free);
+    tcase_add_test(tc_core, complexity_linear_scaling);
+    tcase_add_test(tc_core, complexity_sorted_logarithmic);
+    tcase_add_test(tc_core, complexity_large_scale);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+START_TEST(tools_malloc_free_manual8)
+{
+    uint32_t startMem = allocatedMem;
+    size_t mallocSize = 128;
+    void* ptr1 = tracedMalloc(mallocSize);
+
+    ck_assert_int_eq(startMem, allocatedMem - mallocSize);
+
+    void* ptr2 = tracedMalloc(mallocSize);
+    void* ptr3 = tracedMalloc(mallocSize);
+    void* ptr4 = tracedMalloc(mallocSize);
+    void* ptr5 = tracedMalloc(mallocSize);
+    void* ptr6 = tracedMalloc(mallocSize);
+    void* ptr7 = tracedMalloc(mallocSize);
+    void* ptr8 = tracedMalloc(mallocSize);
+
+    ck_assert_int_eq(startMem, allocatedMem - (8 * mallocSize) );
+
+    tracedFree(ptr1);
+    tracedFree(ptr2);
+    tracedFree(ptr3);
+    tracedFree(ptr4);
+    tracedFree(ptr5);
+    tracedFree(ptr6);
+    tracedFree(ptr7);
+    tracedFree(ptr8);
+
+    ck_assert_int_eq(startMem, allocatedMem);
+
+}
+
+START_TEST(tools_malloc_free_loop_all)
+{
+    uint32_t memStart = allocatedMem;
+    size_t mallocSize = 16;
+    void** memtable;
+    memtable = (void**)malloc(sizeof(void*)*MAX_ALLOCATED_BLOCKS);
+
+    for ( uint32_t i = 0; i < MAX_ALLOCATED_BLOCKS; i++)
+    {
+        memtable[i] = tracedMalloc(mallocSize);
+    }
+
+    ck_assert_int_eq(memStart, allocatedMem - MAX_ALLOCATED_BLOCKS * mallocSize);
+
+    for ( uint32_t i = 0; i < MAX_ALLOCATED_BLOCKS; i++)
+    {
+        tracedFree(memtable[i]);
+    }
+
+    ck_assert_int_eq(memStart, allocatedMem);
+    free(memtable);
+
+}
+
+Suite * tools_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("tools-test");
+
+    /* Core test case */
+    tc_core = tcase_create("Tools");
+
+    tcase_add_test(tc_core, tools_malloc_free_manual8);
+    tcase_add_test(tc_core, tools_malloc_free_loop_all);
+
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed = 0;
+    Suite *listSuite;
+    Suite *toolsSuite;
+    Suite *sortedSuite;
+    Suite *snapshotSuite;
+    Suite *nodeCacheSuite;
+    Suite *nodeArenaSuite;
+    Suite *keyedSuite;
+    Suite *concurrentSuite;
+    Suite *viewSuite;
+    Suite *metricsSuite;
+    Suite *complexitySuite;
+    SRunner *toolsSr;
+    SRunner *sr;
+    SRunner *sortedSr;
+    SRunner *snapshotSr;
+    SRunner *nodeCacheSr;
+    SRunner *nodeArenaSr;
+    SRunner *keyedSr;
+    SRunner *concurrentSr;
+    SRunner *viewSr;
+    SRunner *metricsSr;
+    SRunner *complexitySr;
+
+    listSuite = generic_list_suite();
+    toolsSuite = tools_suite();
+    sortedSuite = sorted_list_suite();
+    snapshotSuite = snapshot_list_suite();
+    nodeCacheSuite = node_cache_suite();
+    nodeArenaSuite = node_arena_suite();
+    keyedSuite = keyed_list_suite();
+    concurrentSuite = concurrent_list_suite();
+    viewSuite = list_view_suite();
+    metricsSuite = list_metrics_suite();
+    complexitySuite = complexity_suite();
+
+    toolsSr = srunner_create(toolsSuite);
+
+    sr = srunner_create(listSuite);
+
+    sortedSr = srunner_create(sortedSuite);
+
+    snapshotSr = srunner_create(snapshotSuite);
+
+    nodeCacheSr = srunner_create(nodeCacheSuite);
+
+    nodeArenaSr = srunner_create(nodeArenaSuite);
+
+    keyedSr = srunner_create(keyedSuite);
+
+    concurrentSr = srunner_create(concurrentSuite);
+
+    viewSr = srunner_create(viewSuite);
+
+    metricsSr = srunner_create(metricsSuite);
+
+    complexitySr = srunner_create(complexitySuite);
 
     printf("Tests start\r\n");
     srunner_run_all(toolsSr, CK_NORMAL);
     srunner_run_all(sr, CK_NORMAL);
+    srunner_run_all(sortedSr, CK_NORMAL);
+    srunner_run_all(snapshotSr, CK_NORMAL);
+    srunner_run_all(nodeCacheSr, CK_NORMAL);
+    srunner_run_all(nodeArenaSr, CK_NORMAL);
+    srunner_run_all(keyedSr, CK_NORMAL);
+    srunner_run_all(concurrentSr, CK_NORMAL);
+    srunner_run_all(viewSr, CK_NORMAL);
+    srunner_run_all(metricsSr, CK_NORMAL);
+    srunner_run_all(complexitySr, CK_NORMAL);
     number_failed += srunner_ntests_failed(toolsSr);
     number_failed += srunner_ntests_failed(sr);
+    number_failed += srunner_ntests_failed(sortedSr);
+    number_failed += srunner_ntests_failed(snapshotSr);
+    number_failed += srunner_ntests_failed(nodeCacheSr);
+    number_failed += srunner_ntests_failed(nodeArenaSr);
+    number_failed += srunner_ntests_failed(keyedSr);
+    number_failed += srunner_ntests_failed(concurrentSr);
+    number_failed += srunner_ntests_failed(viewSr);
+    number_failed += srunner_ntests_failed(metricsSr);
+    number_failed += srunner_ntests_failed(complexitySr);
     srunner_free(toolsSr);
     srunner_free(sr);
+    srunner_free(sortedSr);
+    srunner_free(snapshotSr);
+    srunner_free(nodeCacheSr);
+    srunner_free(nodeArenaSr);
+    srunner_free(keyedSr);
+    srunner_free(concurrentSr);
+    srunner_free(viewSr);
+    srunner_free(metricsSr);
+    srunner_free(complexitySr);
     return (number_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
 
     return 0;
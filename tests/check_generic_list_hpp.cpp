@@ -0,0 +1,337 @@
+/*********************************************************************************
+ * Copyright (c) 2021 Konrad Foit                                                *
+ *                                                                               *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy  *
+ * of this software and associated documentation files (the "Software"), to deal *
+ * in the Software without restriction, including without limitation the rights  *
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell     *
+ * copies of the Software, and to permit persons to whom the Software is         *
+ * furnished to do so, subject to the following conditions:                      *
+ *                                                                               *
+ * The above copyright notice and this permission notice shall be included in all*
+ * copies or substantial portions of the Software.                               *
+ *                                                                               *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR    *
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,      *
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE   *
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER        *
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, *
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE *
+ * SOFTWARE.                                                                     *
+ *********************************************************************************/
+
+/** @file check_generic_list_hpp.cpp
+ * @brief Unit tests using Check for the C++ generic-list wrapper
+ *
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <check.h>
+#include "generic_list.hpp"
+#include "list_metrics.h"
+
+/* Memory resource counting allocations, forwards to new/delete */
+class counting_resource : public std::pmr::memory_resource
+{
+public:
+    size_t allocs = 0;
+    size_t frees = 0;
+    size_t liveBytes = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override
+    {
+        allocs++;
+        liveBytes += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override
+    {
+        frees++;
+        liveBytes -= bytes;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+/* Payload counting constructions, copies and destructions */
+struct tracked_item
+{
+    static int live;
+    static int copies;
+    int a;
+    std::string b;
+
+    tracked_item(int x, const char* y) : a(x), b(y) { live++; }
+    tracked_item(const tracked_item& other) : a(other.a), b(other.b) { live++; copies++; }
+    tracked_item(tracked_item&& other) noexcept : a(other.a), b(std::move(other.b)) { live++; copies++; }
+    tracked_item& operator=(const tracked_item&) = default;
+    ~tracked_item() { live--; }
+};
+
+int tracked_item::live = 0;
+int tracked_item::copies = 0;
+
+struct throwing_item
+{
+    explicit throwing_item(bool fail)
+    {
+        if ( fail )
+        {
+            throw std::runtime_error("construction failed");
+        }
+    }
+};
+
+START_TEST(hpp_emplace_and_destroy)
+{
+    counting_resource resource;
+    tracked_item::live = 0;
+    tracked_item::copies = 0;
+    {
+        generic_list::list<tracked_item> list(&resource);
+        ck_assert(list.empty());
+        for ( int i = 0; i < 10; i++ )
+        {
+            tracked_item& item = list.emplace_back(i, "item");
+            ck_assert_int_eq(item.a, i);
+        }
+        list.emplace_front(-1, "first");
+
+        /* Payloads constructed in place, one allocation per element */
+        ck_assert_int_eq(tracked_item::copies, 0);
+        ck_assert_int_eq(tracked_item::live, 11);
+        ck_assert_uint_eq(resource.allocs, 11);
+        ck_assert_uint_eq(list.size(), 11);
+        ck_assert_int_eq(list.front().a, -1);
+        ck_assert_int_eq(list.back().a, 9);
+
+        /* C view sees the same payloads */
+        ck_assert_uint_eq(list.c_list()->size, 11);
+        ck_assert_int_eq(static_cast<tracked_item*>(list.c_list()->head->data)->a, -1);
+
+        list.pop_front();
+        list.pop_back();
+        ck_assert_int_eq(tracked_item::live, 9);
+        ck_assert_uint_eq(resource.frees, 2);
+    }
+    ck_assert_int_eq(tracked_item::live, 0);
+    ck_assert_uint_eq(resource.allocs, resource.frees);
+    ck_assert_uint_eq(resource.liveBytes, 0);
+}
+END_TEST
+
+START_TEST(hpp_iterators)
+{
+    generic_list::list<int> list;
+    std::vector<int> values;
+    int sum = 0;
+
+    for ( int i = 0; i < 8; i++ )
+    {
+        list.push_back(i);
+    }
+    for ( int value : list )
+    {
+        sum += value;
+    }
+    ck_assert_int_eq(sum, 28);
+
+    /* Bidirectional iterators work with <algorithm> */
+    ck_assert(std::find(list.begin(), list.end(), 5) != list.end());
+    ck_assert(std::find(list.begin(), list.end(), 42) == list.end());
+    std::reverse(list.begin(), list.end());
+    ck_assert_int_eq(list.front(), 7);
+    ck_assert_int_eq(*std::prev(list.end()), 0);
+    std::copy(list.crbegin(), list.crend(), std::back_inserter(values));
+    ck_assert(values == std::vector<int>({ 0, 1, 2, 3, 4, 5, 6, 7 }));
+
+    /* Erase odd values, insert in front of an iterator */
+    auto it = list.begin();
+    while ( it != list.end() )
+    {
+        it = ( *it % 2 ) ? list.erase(it) : std::next(it);
+    }
+    ck_assert_uint_eq(list.size(), 4);
+    it = list.insert(std::find(list.cbegin(), list.cend(), 2), 3);
+    ck_assert_int_eq(*it, 3);
+    ck_assert_int_eq(*std::next(it), 2);
+    ck_assert_int_eq(*std::prev(it), 4);
+
+    list.erase(list.begin(), list.end());
+    ck_assert(list.empty());
+    ck_assert(list.begin() == list.end());
+}
+END_TEST
+
+START_TEST(hpp_move)
+{
+    counting_resource resource;
+    generic_list::list<std::string> list(&resource);
+    list.emplace_back("a");
+    list.emplace_back("b");
+    size_t allocs = resource.allocs;
+
+    /* Moving transfers nodes without touching them */
+    generic_list::list<std::string> moved(std::move(list));
+    ck_assert_uint_eq(resource.allocs, allocs);
+    ck_assert_uint_eq(moved.size(), 2);
+    ck_assert_uint_eq(list.size(), 0);
+    ck_assert(list.begin() == list.end());
+    ck_assert_ptr_eq(moved.resource(), &resource);
+
+    /* Moved-from list is still usable */
+    list.emplace_back("c");
+    ck_assert_str_eq(list.front().c_str(), "c");
+
+    list = std::move(moved);
+    ck_assert_uint_eq(list.size(), 2);
+    ck_assert_str_eq(list.back().c_str(), "b");
+    ck_assert_uint_eq(resource.frees, 1);
+
+    swap(list, moved);
+    ck_assert_uint_eq(list.size(), 0);
+    ck_assert_uint_eq(moved.size(), 2);
+    moved.clear();
+    ck_assert_uint_eq(resource.allocs, resource.frees);
+}
+END_TEST
+
+START_TEST(hpp_resource_and_errors)
+{
+    /* Monotonic buffer needs no per node deallocation */
+    char buffer[4096];
+    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer), std::pmr::null_memory_resource());
+    generic_list::list<long> list(&arena);
+    bool thrown = false;
+
+    for ( long i = 0; i < 16; i++ )
+    {
+        list.push_back(i);
+    }
+    ck_assert_uint_eq(list.size(), 16);
+
+    /* Exhausted resource reports std::bad_alloc, list unchanged */
+    try
+    {
+        for ( int i = 0; i < 4096; i++ )
+        {
+            list.push_back(static_cast<long>(list.size()));
+        }
+    }
+    catch ( const std::bad_alloc& )
+    {
+        thrown = true;
+    }
+    ck_assert(thrown);
+    ck_assert_int_eq(list.back(), static_cast<long>(list.size()) - 1);
+
+    /* Throwing constructor leaves no node behind */
+    counting_resource resource;
+    {
+        generic_list::list<throwing_item> items(&resource);
+        items.emplace_back(false);
+        thrown = false;
+        try
+        {
+            items.emplace_back(true);
+        }
+        catch ( const std::runtime_error& )
+        {
+            thrown = true;
+        }
+        ck_assert(thrown);
+        ck_assert_uint_eq(items.size(), 1);
+    }
+    ck_assert_uint_eq(resource.allocs, resource.frees);
+
+    thrown = false;
+    try
+    {
+        generic_list::list<int> invalid(nullptr);
+    }
+    catch ( const generic_list::list_exception& e )
+    {
+        thrown = ( LIST_INVALID_PARAM == e.code() );
+    }
+    ck_assert(thrown);
+}
+END_TEST
+
+START_TEST(hpp_metrics)
+{
+    list_metrics_t* metrics = nullptr;
+    list_op_stats_t stats;
+    uint64_t ns;
+    char* text = nullptr;
+    size_t length = 0;
+    FILE* out;
+
+    /* Histograms are usable from C++ and can be attached to wrapped lists */
+    ck_assert_int_eq(listMetrics_newMetrics(&metrics, free, malloc), LIST_SUCCESS);
+    generic_list::list<int> list;
+    ck_assert_int_eq(genericList_setMetrics(list.c_list(), metrics), LIST_SUCCESS);
+    list.emplace_back(1);
+    ck_assert_int_eq(listMetrics_record(metrics, LIST_OP_APPEND, 100), LIST_SUCCESS);
+    ck_assert_int_eq(listMetrics_getStats(metrics, LIST_OP_APPEND, &stats), LIST_SUCCESS);
+    ck_assert_uint_ge(stats.count, 1);
+    ck_assert_int_eq(listMetrics_percentile(metrics, LIST_OP_APPEND, 100.0, &ns), LIST_SUCCESS);
+    ck_assert_uint_ge(ns, 100);
+
+    out = open_memstream(&text, &length);
+    ck_assert_ptr_ne(out, nullptr);
+    ck_assert_int_eq(listMetrics_export(metrics, LIST_METRICS_JSON, out), LIST_SUCCESS);
+    fclose(out);
+    ck_assert_ptr_ne(std::strstr(text, "\"append\""), nullptr);
+    free(text);
+
+    ck_assert_int_eq(genericList_setMetrics(list.c_list(), nullptr), LIST_SUCCESS);
+    ck_assert_int_eq(listMetrics_freeMetrics(metrics), LIST_SUCCESS);
+}
+END_TEST
+
+Suite * generic_list_hpp_suite(void)
+{
+    Suite *s;
+    TCase *tc_core;
+
+    s = suite_create("generic-list-hpp");
+
+    /* Core test case */
+    tc_core = tcase_create("Core");
+
+    tcase_add_test(tc_core, hpp_emplace_and_destroy);
+    tcase_add_test(tc_core, hpp_iterators);
+    tcase_add_test(tc_core, hpp_move);
+    tcase_add_test(tc_core, hpp_resource_and_errors);
+    tcase_add_test(tc_core, hpp_metrics);
+    suite_add_tcase(s, tc_core);
+
+    return s;
+}
+
+int main(void)
+{
+    int number_failed;
+    Suite *s;
+    SRunner *sr;
+
+    s = generic_list_hpp_suite();
+    sr = srunner_create(s);
+
+    srunner_run_all(sr, CK_NORMAL);
+    number_failed = srunner_ntests_failed(sr);
+    srunner_free(sr);
+    return ( number_failed == 0 ) ? EXIT_SUCCESS : EXIT_FAILURE;
+}